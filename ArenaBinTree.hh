@@ -0,0 +1,287 @@
+#ifndef ARENABINTREE_HH
+#define ARENABINTREE_HH
+
+#ifndef NO_DIAGRAM
+#include <cassert>
+#include <new>
+#include <type_traits>
+#include <algorithm>
+#endif
+
+using namespace std;
+
+// An ArenaBinTree<T> implements binary trees with values of type T, with the
+// same empty()/left()/right()/value() interface as BinTree<T>.
+//
+// Instead of one shared_ptr per node, nodes are bump-allocated from blocks
+// that belong to an arena. The arena counts the trees that refer to it, with
+// plain (non-atomic) integers, and all its nodes are released together when
+// the last of them goes away. A tree built from two subtrees of different
+// arenas joins them in Θ(1) by handing the blocks of one to the other.
+//
+// A tree with no subtrees starts a small arena of its own, unless it is
+// built while a Region lives: then it goes to the arena of the region, so
+// that a whole tree built bottom-up ends up in a few large blocks:
+//
+//     ArenaBinTree<string> t;
+//     {
+//       ArenaBinTree<string>::Region r;
+//       t = read(...);           // every node of t in the same arena
+//     }
+//
+// Nodes are never freed one by one: a subtree that is no longer referenced
+// keeps its memory until the whole arena is released. That is what a tree
+// that is built once and then replaced as a whole wants.
+//
+// Trees that share nodes share their arena, so they must all be used from
+// the same thread.
+template <typename T>
+class ArenaBinTree {
+
+  struct Node {
+    T x;
+    Node* left;
+    Node* right;
+
+    Node (const T& x, Node* left, Node* right)
+      :   x(x), left(left), right(right)
+    {   }
+  };
+
+  // A block of nodes, of which the first 'used' are constructed.
+  struct Block {
+    Block* next;
+    Node* nodes;
+    int used, capacity;
+  };
+
+  // Blocks of nodes, the first one being filled, and number of references
+  // from trees, regions and joined arenas. Once joined into another arena,
+  // 'into' points to it, its blocks belong to it and this arena holds one
+  // reference to it.
+  struct Arena {
+    Block* first;
+    Block* last;
+    int refs;
+    int nextcapacity;
+    Arena* into;
+  };
+
+  // Nodes of the first block of the arena of a region and of a tree with
+  // no subtrees, and maximum nodes of a block.
+  static const int REGIONBLOCK = 64;
+  static const int LEAFBLOCK = 1;
+  static const int MAXBLOCK = 1 << 16;
+
+  // Arena of the innermost region of this thread, or null.
+  static thread_local Arena* region;
+
+  // A tree holds a node pointer and the arena that keeps it alive.
+  Node* p;
+  Arena* a;
+
+  // Constructs a tree from a node of an arena. Θ(1).
+  ArenaBinTree (Node* p, Arena* a)
+    :   p(p), a(a)
+  {
+    retain(a);
+  }
+
+  static Arena* newArena(int firstcapacity) {
+    Arena* a = new Arena;
+    a->first = a->last = nullptr;
+    a->refs = 0;
+    a->nextcapacity = firstcapacity;
+    a->into = nullptr;
+    return a;
+  }
+
+  static void retain(Arena* a) {
+    if (a) ++a->refs;
+  }
+
+  // Drops a reference and releases the arenas left without any.
+  // Θ(1) per block, plus the destructors of T if it has them.
+  static void release(Arena* a) {
+    while (a and --a->refs == 0) {
+      Arena* into = a->into;
+      for (Block* b = a->first; b; ) {
+        Block* next = b->next;
+        if (not is_trivially_destructible<T>::value)
+          for (int i = 0; i < b->used; ++i) b->nodes[i].~Node();
+        ::operator delete(b->nodes);
+        delete b;
+        b = next;
+      }
+      delete a;
+      a = into;
+    }
+  }
+
+  // Returns the arena that currently holds the blocks of a, or null.
+  static Arena* root(Arena* a) {
+    while (a and a->into) a = a->into;
+    return a;
+  }
+
+  // Joins two root arenas and returns the one that holds both. Θ(1).
+  static Arena* join(Arena* a, Arena* b) {
+    if (not a) return b;
+    if (not b or a == b) return a;
+    // The blocks of b go after the block a is filling.
+    if (b->first) {
+      if (a->first) {
+        b->last->next = a->first->next;
+        a->first->next = b->first;
+        if (a->last == a->first) a->last = b->last;
+      } else {
+        a->first = b->first;
+        a->last = b->last;
+      }
+      b->first = b->last = nullptr;
+    }
+    b->into = a;
+    ++a->refs;
+    return a;
+  }
+
+  // Constructs a node at the end of the block a root arena is filling.
+  static Node* allocate(Arena* a, const T& x, Node* left, Node* right) {
+    Block* b = a->first;
+    if (not b or b->used == b->capacity) {
+      Block* nb = new Block;
+      nb->capacity = a->nextcapacity;
+      nb->nodes = static_cast<Node*>(::operator new(nb->capacity*sizeof(Node)));
+      nb->used = 0;
+      nb->next = b;
+      a->first = nb;
+      if (not b) a->last = nb;
+      a->nextcapacity = min(2*a->nextcapacity, int(MAXBLOCK));
+      b = nb;
+    }
+    Node* n = new (b->nodes + b->used) Node(x, left, right);
+    ++b->used;
+    return n;
+  }
+
+  // Returns a root arena, with one more reference, for a node over the
+  // subtrees of arenas left and right.
+  static Arena* arenaFor(Arena* left, Arena* right) {
+    Arena* a = join(root(left), root(right));
+    if (not a) a = (region ? root(region) : newArena(LEAFBLOCK));
+    ++a->refs;
+    return a;
+  }
+
+public:
+
+  // While a Region lives, the trees with no subtrees built in this thread
+  // put their nodes in a new arena shared by all of them, instead of
+  // starting one each. Regions can be nested; the innermost one is used.
+  class Region {
+    Arena* a;
+    Arena* previous;
+
+  public:
+    Region ()
+      :   a(newArena(REGIONBLOCK)), previous(region)
+    {
+      a->refs = 1;
+      region = a;
+    }
+
+    // The arena lives on while any tree built in it does.
+    ~Region () {
+      region = previous;
+      release(a);
+    }
+
+    Region (const Region&) = delete;
+    Region& operator=(const Region&) = delete;
+  };
+
+  // Constructs an empty tree. Θ(1).
+  ArenaBinTree ()
+    :   p(nullptr), a(nullptr)
+  {   }
+
+  ArenaBinTree (const ArenaBinTree& t)
+    :   p(t.p), a(t.a)
+  {
+    retain(a);
+  }
+
+  ArenaBinTree (ArenaBinTree&& t) noexcept
+    :   p(t.p), a(t.a)
+  {
+    t.p = nullptr;
+    t.a = nullptr;
+  }
+
+  ArenaBinTree& operator=(const ArenaBinTree& t) {
+    retain(t.a);
+    release(a);
+    p = t.p;
+    a = t.a;
+    return *this;
+  }
+
+  ArenaBinTree& operator=(ArenaBinTree&& t) noexcept {
+    if (this != &t) {
+      release(a);
+      p = t.p;
+      a = t.a;
+      t.p = nullptr;
+      t.a = nullptr;
+    }
+    return *this;
+  }
+
+  // Releases the arena if this is the last tree that uses it.
+  ~ArenaBinTree () {
+    release(a);
+  }
+
+  // Constructs a tree with a value x and no subtrees. Θ(1).
+  explicit ArenaBinTree (const T& x)
+    :   a(arenaFor(nullptr, nullptr))
+  {
+    p = allocate(a, x, nullptr, nullptr);
+  }
+
+  // Constructs a tree with a value x and two subtrees left and right. Θ(1),
+  // plus the length of the chains of joined arenas of left and right.
+  explicit ArenaBinTree (const T& x, const ArenaBinTree& left, const ArenaBinTree& right)
+    :   a(arenaFor(left.a, right.a))
+  {
+    p = allocate(a, x, left.p, right.p);
+  }
+
+  // Tells if this tree is empty. Θ(1).
+  bool empty () const {
+    return not p;
+  }
+
+  // Returns the left subtree of this tree (cannot be empty). Θ(1).
+  ArenaBinTree left () const {
+    assert(not empty());
+    return ArenaBinTree(p->left, p->left ? a : nullptr);
+  }
+
+  // Returns the right subtree of this tree (cannot be empty). Θ(1).
+  ArenaBinTree right () const {
+    assert(not empty());
+    return ArenaBinTree(p->right, p->right ? a : nullptr);
+  }
+
+  // Returns the value of this tree (cannot be empty). Θ(1).
+  const T& value () const {
+    assert(not empty());
+    return p->x;
+  }
+};
+
+template <typename T>
+thread_local typename ArenaBinTree<T>::Arena* ArenaBinTree<T>::region = nullptr;
+
+#endif
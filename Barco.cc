@@ -35,19 +35,22 @@ void Barco::reiniciar_lista() {
 
 // Pre: num_comprar > 0, num_vender > 0.
 // Post El barco contiene el ID del producto que comprar,
-// vender, y el número de elementos de ambos.
+// vender, y el número de elementos de ambos. Si los productos no son
+// válidos, se escribe el error, el barco no cambia y se devuelve falso.
 
-void Barco::modificar_barco(int id_producto_comprar, int num_comprar, int id_producto_vender, int num_vender, const Cjt_productos& cp) {
+bool Barco::modificar_barco(int id_producto_comprar, int num_comprar, int id_producto_vender, int num_vender, const Cjt_productos& cp) {
     if (!cp.hay_prod(id_producto_comprar) or !cp.hay_prod(id_producto_vender)) {
-        cout << "error: no existe el producto" << endl;
+        salida << "error: no existe el producto\n";
+        return false;
     } else if (id_producto_comprar == id_producto_vender) {
-        cout << "error: no se puede comprar y vender el mismo producto" << endl;
-    } else {
-        _id_prod_comprar = id_producto_comprar;
-        _num_comprar = num_comprar;
-        _id_prod_vender = id_producto_vender;
-        _num_vender = num_vender;
+        salida << "error: no se puede comprar y vender el mismo producto\n";
+        return false;
     }
+    _id_prod_comprar = id_producto_comprar;
+    _num_comprar = num_comprar;
+    _id_prod_vender = id_producto_vender;
+    _num_vender = num_vender;
+    return true;
 }
 
 // Pre: cierto.
@@ -95,9 +98,42 @@ int Barco::consultar_num_vender() const {
 // las últimas ciudades de los diferentes viajes en orden cronológico.
 
 void Barco::escribir_barco() const {
-    cout << _id_prod_comprar << ' ' << _num_comprar << ' ' << _id_prod_vender << ' ' << _num_vender << endl;
+    salida << _id_prod_comprar << ' ' << _num_comprar << ' ' << _id_prod_vender << ' ' << _num_vender << '\n';
     for (auto it = _ult_ciudad.begin(); it != _ult_ciudad.end(); ++it) {
-        cout << *it << endl;
+        salida << *it << '\n';
     }
 }
 
+// Estado binario
+
+// Pre: Barco inicializado.
+// Post: Se han escrito en out los productos a comprar y vender, sus cantidades
+// y las últimas ciudades en orden cronológico.
+
+void Barco::guardar(Escritor_binario& out) const {
+    out.entero(_id_prod_comprar);
+    out.entero(_num_comprar);
+    out.entero(_id_prod_vender);
+    out.entero(_num_vender);
+    out.entero(_ult_ciudad.size());
+    for (auto it = _ult_ciudad.begin(); it != _ult_ciudad.end(); ++it) {
+        out.cadena(*it);
+    }
+}
+
+// Pre: En in se encuentra un barco escrito con guardar.
+// Post: El parámetro implícito pasa a tener la configuración y las ciudades
+// leídas. Devuelve falso si los productos a comprar o vender no existen en cp.
+
+bool Barco::cargar(Lector_binario& in, const Cjt_productos& cp) {
+    _id_prod_comprar = in.entero();
+    _num_comprar = in.entero();
+    _id_prod_vender = in.entero();
+    _num_vender = in.entero();
+    _ult_ciudad.clear();
+    int n = in.entero();
+    for (int i = 0; i < n and in.ok(); ++i) {
+        _ult_ciudad.push_back(in.cadena());
+    }
+    return cp.hay_prod(_id_prod_comprar) and cp.hay_prod(_id_prod_vender);
+}
@@ -67,9 +67,10 @@ public:
   /** @brief Modificadora para el barco.
       \pre num_comprar > 0, num_vender > 0.
       \post El barco contiene el ID del producto que comprar,
-      vender, y el número de elementos de ambos.
+      vender, y el número de elementos de ambos. Si los productos no son
+      válidos, se escribe el error, el barco no cambia y se devuelve falso.
   */
-  void modificar_barco(int id_producto_comprar, int num_comprar, int id_producto_vender, int num_vender, const Cjt_productos& cp);
+  bool modificar_barco(int id_producto_comprar, int num_comprar, int id_producto_vender, int num_vender, const Cjt_productos& cp);
 
   /** @brief Modificadora para la última ciudad.
       \pre <em>cierto<em>
@@ -112,6 +113,22 @@ public:
       las últimas ciudades de los diferentes viajes en orden cronológico.
   */
   void escribir_barco() const;
+
+  // Estado binario
+
+  /** @brief Guarda el barco en un estado binario.
+      \pre Barco inicializado.
+      \post Se han escrito en out los productos a comprar y vender, sus cantidades
+      y las últimas ciudades en orden cronológico.
+  */
+  void guardar(Escritor_binario& out) const;
+
+  /** @brief Carga el barco de un estado binario.
+      \pre En in se encuentra un barco escrito con guardar.
+      \post El parámetro implícito pasa a tener la configuración y las ciudades
+      leídas. Devuelve falso si los productos a comprar o vender no existen en cp.
+  */
+  bool cargar(Lector_binario& in, const Cjt_productos& cp);
 };
 
 #endif
@@ -14,9 +14,119 @@
 #include <stack>
 #include <sstream>
 #include <vector>
+#include <iterator>
+#include <utility>
+#include <type_traits>
 
 using namespace std;
 
+// Tag of the BinTree constructor that builds the value of the root in place.
+struct BinTreeEmplace {};
+const BinTreeEmplace BINTREEEMPLACE = BinTreeEmplace();
+
+// Variable-length unsigned numbers of BINARYFORMAT: 7 bits per byte, the
+// lowest first, with the high bit set in every byte but the last.
+struct BinTreeNumber {
+  static bool write(streambuf &sb, unsigned long long n) {
+    while (n >= 0x80) {
+      if (sb.sputc(char((n & 0x7f) | 0x80)) == EOF) return false;
+      n >>= 7;
+    }
+    return sb.sputc(char(n)) != EOF;
+  }
+
+  static bool read(streambuf &sb, unsigned long long &n) {
+    n = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      int c = sb.sbumpc();
+      if (c == EOF) return false;
+      n |= (unsigned long long)(c & 0x7f) << shift;
+      if (c < 0x80) return true;
+    }
+    return false;
+  }
+};
+
+// Bytes of BINARYFORMAT: a length and that many bytes.
+struct BinTreeBytes {
+  static bool write(streambuf &sb, const string &x) {
+    return BinTreeNumber::write(sb, x.size()) and sb.sputn(x.data(), x.size()) == streamsize(x.size());
+  }
+
+  static bool read(streambuf &sb, string &x) {
+    unsigned long long n;
+    if (not BinTreeNumber::read(sb, n)) return false;
+    // In pieces, so that a wrong length fails at the end of the input
+    // instead of reserving it all at once.
+    x.clear();
+    while (n > 0) {
+      size_t old = x.size();
+      size_t piece = min(n, 1ULL << 16);
+      x.resize(old + piece);
+      if (sb.sgetn(&x[old], piece) != streamsize(piece)) return false;
+      n -= piece;
+    }
+    return true;
+  }
+};
+
+// Encoding of the values of a BinTree in BINARYFORMAT, straight on the
+// stream buffer. By default a value is written with operator<< and read
+// with operator>>, as length-prefixed bytes; strings and integers have their
+// own encodings below, which never go through intermediate strings.
+template <typename T, bool INTEGRAL = is_integral<T>::value>
+struct BinTreeCodec {
+  static bool write(streambuf &sb, const T &x) {
+    ostringstream os;
+    os << x;
+    return BinTreeBytes::write(sb, os.str());
+  }
+
+  static bool read(streambuf &sb, T &x) {
+    string s;
+    if (not BinTreeBytes::read(sb, s)) return false;
+    istringstream is(s);
+    return bool(is >> x);
+  }
+};
+
+// Strings: the length and the bytes.
+template <>
+struct BinTreeCodec<string, false> {
+  static bool write(streambuf &sb, const string &x) {
+    return BinTreeBytes::write(sb, x);
+  }
+
+  static bool read(streambuf &sb, string &x) {
+    return BinTreeBytes::read(sb, x);
+  }
+};
+
+// Integers: a variable-length number, signed ones in zigzag so that small
+// negative values are short too.
+template <typename T>
+struct BinTreeCodec<T, true> {
+  static bool write(streambuf &sb, const T &x) {
+    if (is_signed<T>::value) {
+      long long v = x;
+      return BinTreeNumber::write(sb, (unsigned long long)(v) << 1 ^ (unsigned long long)(v >> 63));
+    }
+    return BinTreeNumber::write(sb, (unsigned long long)(x));
+  }
+
+  static bool read(streambuf &sb, T &x) {
+    unsigned long long n;
+    if (not BinTreeNumber::read(sb, n)) return false;
+    if (is_signed<T>::value) {
+      long long v = (long long)(n >> 1) ^ -(long long)(n & 1);
+      x = T(v);
+      return (long long)(x) == v;
+    }
+    x = T(n);
+    return (unsigned long long)(x) == n;
+  }
+};
+
 // A BinTree<T> implements binary trees with values of type T.
 template <typename T>
 class BinTree {
@@ -27,7 +137,16 @@ class BinTree {
     shared_ptr<Node> right;
 
     Node (const T& x, shared_ptr<Node> left, shared_ptr<Node> right)
-      :   x(x), left(left), right(right)
+      :   x(x), left(move(left)), right(move(right))
+    {   }
+
+    Node (T&& x, shared_ptr<Node> left, shared_ptr<Node> right)
+      :   x(move(x)), left(move(left)), right(move(right))
+    {   }
+
+    template <typename... Args>
+    Node (BinTreeEmplace, shared_ptr<Node> left, shared_ptr<Node> right, Args&&... args)
+      :   x(forward<Args>(args)...), left(move(left)), right(move(right))
     {   }
 
   };
@@ -37,13 +156,12 @@ class BinTree {
 
   // Constructs a tree from a node pointer.
   BinTree (shared_ptr<Node> p)
-    :   p(p)
+    :   p(move(p))
   {   }    
     
   // Notes:
-  //   - default operator=() is good.
   //   - default destructor is good. Θ(n) where n is the number of nodes in the tree.
-  //   - std::swap() already works by default.
+  //   - std::swap() already works by default, with the move operations.
 
 
 
@@ -53,7 +171,8 @@ class BinTree {
     if (format == POSTORDERFORMAT or
 	format == LEFTVISUALFORMAT or
 	format == VISUALFORMAT or
-	format == INLINEFORMAT)
+	format == INLINEFORMAT or
+	format == BINARYFORMAT)
       return;
     std::cerr << "ERROR: wrong tree format" << std::endl;
     exit(1);
@@ -83,6 +202,8 @@ class BinTree {
   static void readVisualFormat(const vector<string> &v, BinTree<T> &t);
   static vector<string> generateVisualFormatRec(const BinTree<T> &t);
   static vector<string> generateVisualFormat(const BinTree<T> &t);
+  static void writeBinary(std::ostream &os, const BinTree<T> &t);
+  static void readBinary(std::istream &is, BinTree<T> &t);
 
   
 public:
@@ -106,6 +227,21 @@ public:
     p = t.p;
     return *this;
   }
+
+  // The moved-from tree is left empty. Θ(1), without touching reference counts.
+  BinTree(BinTree &&t) noexcept
+    :   p(move(t.p))
+  {
+    inputformat=t.inputformat;
+    outputformat=t.outputformat;
+  }
+
+  BinTree &operator=(BinTree &&t) noexcept {
+    inputformat=t.inputformat;
+    outputformat=t.outputformat;
+    p = move(t.p);
+    return *this;
+  }
 	
   // Constructs a tree with a value x and no subtrees. Θ(1).
   explicit BinTree (const T& x) {
@@ -113,12 +249,37 @@ public:
     p = make_shared<Node>(x, nullptr, nullptr);
   }
 
+  explicit BinTree (T&& x) {
+    inputformat = outputformat = INLINEFORMAT;
+    p = make_shared<Node>(move(x), nullptr, nullptr);
+  }
+
   // Constructs a tree with a value x and two subtrees left and right. Θ(1).
   explicit BinTree (const T& x, const BinTree& left, const BinTree& right) {
     inputformat = outputformat = INLINEFORMAT;
     p = make_shared<Node>(x, left.p, right.p);
   }
 
+  // Same, taking over the value and the subtrees, which are left empty.
+  explicit BinTree (T&& x, BinTree&& left, BinTree&& right) {
+    inputformat = outputformat = INLINEFORMAT;
+    p = make_shared<Node>(move(x), move(left.p), move(right.p));
+  }
+
+  explicit BinTree (const T& x, BinTree&& left, BinTree&& right) {
+    inputformat = outputformat = INLINEFORMAT;
+    p = make_shared<Node>(x, move(left.p), move(right.p));
+  }
+
+  // Constructs a tree with two subtrees left and right whose value is built
+  // in place from args, as T(args...). Θ(1) plus the constructor of T.
+  //   BinTree<string> t(BINTREEEMPLACE, BinTree<string>(), BinTree<string>(), 3, 'x');
+  template <typename... Args>
+  explicit BinTree (BinTreeEmplace, BinTree left, BinTree right, Args&&... args) {
+    inputformat = outputformat = INLINEFORMAT;
+    p = make_shared<Node>(BINTREEEMPLACE, move(left.p), move(right.p), forward<Args>(args)...);
+  }
+
   // Tells if this tree is empty. Θ(1).
   bool empty () const {
     return not p;
@@ -149,6 +310,176 @@ public:
   }
 
 
+  // Traversals.
+
+  // Orders in which an Iterator visits the values of a tree.
+  enum Order { PREORDER, INORDER, POSTORDER };
+
+  // Forward iterator over the values of a tree in one of the orders. It
+  // walks the nodes directly: it creates no subtree objects and does not
+  // touch reference counts. The nodes still to come are kept in a stack
+  // inside the iterator, which only allocates memory if the tree is deeper
+  // than INLINEDEPTH. The tree must not be destroyed while it is in use.
+  //   for (const T& x : t.preorder()) ...
+  template <Order order>
+  class Iterator {
+    friend class BinTree;
+
+    static const int INLINEDEPTH = 32;
+
+    // A node of the stack and, in postorder, if its right subtree has
+    // already been entered.
+    struct Step {
+      const Node* node;
+      bool right;
+    };
+
+    const Node* current;     // Node of the current value, or null at the end.
+    int size;                // Number of steps in the stack.
+    Step inlined[INLINEDEPTH];
+    vector<Step> deep;       // Steps from INLINEDEPTH on.
+
+    void push(const Node* node, bool right) {
+      Step s = { node, right };
+      if (size < INLINEDEPTH) inlined[size] = s;
+      else deep.push_back(s);
+      ++size;
+    }
+
+    Step& top() {
+      return size <= INLINEDEPTH ? inlined[size-1] : deep.back();
+    }
+
+    void pop() {
+      if (size > INLINEDEPTH) deep.pop_back();
+      --size;
+    }
+
+    // Inorder: goes down to the leftmost node of n, stacking the way.
+    void leftmost(const Node* n) {
+      for (; n; n = n->left.get()) push(n, false);
+      if (size == 0) current = nullptr;
+      else {
+        current = top().node;
+        pop();
+      }
+    }
+
+    // Postorder: goes down to the first node of n in postorder, stacking
+    // the way, or to the next stacked node if n is empty.
+    void firstpost(const Node* n) {
+      while (n and (n->left or n->right)) {
+        push(n, not n->left);
+        n = n->left ? n->left.get() : n->right.get();
+      }
+      if (n) current = n;
+      else if (size == 0) current = nullptr;
+      else {
+        current = top().node;
+        pop();
+      }
+    }
+
+    explicit Iterator (const Node* root)
+      :   current(nullptr), size(0)
+    {
+      if (order == PREORDER) current = root;
+      else if (order == INORDER) leftmost(root);
+      else firstpost(root);
+    }
+
+  public:
+    typedef forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const T* pointer;
+    typedef const T& reference;
+
+    // Constructs an iterator at the end. Θ(1).
+    Iterator ()
+      :   current(nullptr), size(0)
+    {   }
+
+    const T& operator*() const {
+      return current->x;
+    }
+
+    const T* operator->() const {
+      return &current->x;
+    }
+
+    // Advances to the next value. Θ(1) amortized.
+    Iterator& operator++() {
+      if (order == PREORDER) {
+        if (current->right) push(current->right.get(), false);
+        if (current->left) current = current->left.get();
+        else if (size == 0) current = nullptr;
+        else {
+          current = top().node;
+          pop();
+        }
+      } else if (order == INORDER) {
+        leftmost(current->right.get());
+      } else if (size == 0) {
+        current = nullptr;
+      } else {
+        Step& s = top();
+        if (not s.right and s.node->right) {
+          s.right = true;
+          firstpost(s.node->right.get());
+        } else {
+          current = s.node;
+          pop();
+        }
+      }
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator it = *this;
+      ++*this;
+      return it;
+    }
+
+    bool operator==(const Iterator& it) const {
+      return current == it.current and size == it.size;
+    }
+
+    bool operator!=(const Iterator& it) const {
+      return not (*this == it);
+    }
+  };
+
+  // Values of a tree in one of the orders, for range-based for loops.
+  template <Order order>
+  class Range {
+    const Node* root;
+  public:
+    explicit Range (const Node* root)
+      :   root(root)
+    {   }
+    Iterator<order> begin () const {
+      return Iterator<order>(root);
+    }
+    Iterator<order> end () const {
+      return Iterator<order>();
+    }
+  };
+
+  // Returns the values of this tree in preorder, inorder or postorder. Θ(1).
+  Range<PREORDER> preorder () const {
+    return Range<PREORDER>(p.get());
+  }
+
+  Range<INORDER> inorder () const {
+    return Range<INORDER>(p.get());
+  }
+
+  Range<POSTORDER> postorder () const {
+    return Range<POSTORDER>(p.get());
+  }
+
+
 
   // Fields for managing input/output.
 
@@ -156,6 +487,10 @@ public:
   static const int LEFTVISUALFORMAT = 2;
   static const int VISUALFORMAT = 3;
   static const int INLINEFORMAT = 4;
+  // Compact binary format, for streams opened in binary mode: the number of
+  // nodes and, in preorder, a byte per node telling which subtrees it has
+  // followed by its value (see BinTreeCodec). Θ(n) both ways.
+  static const int BINARYFORMAT = 5;
 
   // Pre: true
   // Post: Sets inputformat of implicit tree and its descendants to 'format'
@@ -316,25 +651,25 @@ void BinTree<T>::readBinTreePostOrder(std::istream &is, BinTree<T> &t)
     int numchildren; // 0: zero, -1: only left, 1: only right, 2: two
     is >> node >> numchildren;
     if (numchildren == 0) {
-      s.push(BinTree<T>(node, BinTree<T>(), BinTree<T>()));
+      s.push(BinTree<T>(move(node), BinTree<T>(), BinTree<T>()));
     } else if (numchildren == -1) {
-      BinTree<T> left = s.top();
+      BinTree<T> left = move(s.top());
       s.pop();
-      s.push(BinTree<T>(node, left, BinTree<T>()));
+      s.push(BinTree<T>(move(node), move(left), BinTree<T>()));
     } else if (numchildren == 1) {
-      BinTree<T> right = s.top();
+      BinTree<T> right = move(s.top());
       s.pop();
-      s.push(BinTree<T>(node, BinTree<T>(), right));
+      s.push(BinTree<T>(move(node), BinTree<T>(), move(right)));
     } else {
-      BinTree<T> right = s.top();
+      BinTree<T> right = move(s.top());
       s.pop();
-      BinTree<T> left = s.top();
+      BinTree<T> left = move(s.top());
       s.pop();
-      s.push(BinTree<T>(node, left, right));
+      s.push(BinTree<T>(move(node), move(left), move(right)));
     }
     --size;
   }
-  if (not s.empty()) t = s.top();
+  if (not s.empty()) t = move(s.top());
 }
 
 template <class T>
@@ -376,14 +711,14 @@ void BinTree<T>::readStringTree(int &itoken,const std::vector<std::pair<std::str
   mycin>>value;
   itoken++;
   if (itoken>=int(vtoken.size()) or vtoken[itoken].first!="(") {
-    t=BinTree<T>(value, BinTree<T>(), BinTree<T>());
+    t=BinTree<T>(move(value), BinTree<T>(), BinTree<T>());
     return;
   }
   itoken++;
   BinTree<T> left;
   readStringTree(itoken,vtoken,left);
   if (itoken>=int(vtoken.size()) or vtoken[itoken].first!=",") {
-    t=BinTree<T>(value,left,BinTree<T>());
+    t=BinTree<T>(move(value),move(left),BinTree<T>());
     if (itoken<int(vtoken.size()) and vtoken[itoken].first==")")
       itoken++;
     return;
@@ -393,7 +728,7 @@ void BinTree<T>::readStringTree(int &itoken,const std::vector<std::pair<std::str
   readStringTree(itoken,vtoken,right);
   if (itoken<int(vtoken.size()) and vtoken[itoken].first==")")
     itoken++;
-  t=BinTree<T>(value,left,right);
+  t=BinTree<T>(move(value),move(left),move(right));
 }
 
 template<typename T>
@@ -465,7 +800,7 @@ void BinTree<T>::readLeftVisualFormatRec(istream &is, int j, BinTree<T> &t) {
   readLeftVisualFormatRec(is, j+4, right);
   BinTree<T> left;
   readLeftVisualFormatRec(is, j+4, left);
-  t = BinTree<T> (value, left, right);
+  t = BinTree<T> (move(value), move(left), move(right));
 }
 
 template<typename T>
@@ -521,14 +856,14 @@ void BinTree<T>::readVisualFormatRec(const vector<string> &v, int i, int j, BinT
   T root;
   string2value(rootstring, root);
   if (int(v.size()) <= i+1) {
-    t = BinTree<T> (root, BinTree<T> (), BinTree<T> ());
+    t = BinTree<T> (move(root), BinTree<T> (), BinTree<T> ());
     return;
   }
   const string &linedown = v[i+1];
   int jdown = jini;
   while (jdown < int(linedown.size()) and jdown <= jend and linedown[jdown] == ' ') jdown++;
   if (int(linedown.size()) <= jdown or jend < jdown) {
-    t = BinTree<T> (root, BinTree<T> (), BinTree<T> ());
+    t = BinTree<T> (move(root), BinTree<T> (), BinTree<T> ());
     return;
   }
   checkFormatCondition(linedown[jdown] == '|');
@@ -549,7 +884,7 @@ void BinTree<T>::readVisualFormatRec(const vector<string> &v, int i, int j, BinT
     checkFormatCondition(0 <= jright and jright < int(line3down.size()) and line3down[jright] == '|');
     readVisualFormatRec(v, i+4, jright, right);
   }
-  t = BinTree<T> (root, left, right);
+  t = BinTree<T> (move(root), move(left), move(right));
 }
 
 template<typename T>
@@ -663,6 +998,59 @@ vector<string> BinTree<T>::generateVisualFormat(const BinTree<T> &t) {
   return v;
 }
 
+////////////////////////////////////////
+////////////////////////////////////////
+////////////////////////////////////////
+////////////////////////////////////////
+// Code reading and writing BINARYFORMAT
+
+template <class T>
+void BinTree<T>::writeBinary(std::ostream &os, const BinTree<T> &t)
+{
+  streambuf &sb = *os.rdbuf();
+  unsigned long long size = 0;
+  for (Iterator<PREORDER> it = t.preorder().begin(); it != Iterator<PREORDER>(); ++it) ++size;
+  bool ok = BinTreeNumber::write(sb, size);
+  // Nodes still to write, the next one on top.
+  vector<const Node*> pending;
+  if (t.p) pending.push_back(t.p.get());
+  while (ok and not pending.empty()) {
+    const Node* n = pending.back();
+    pending.pop_back();
+    ok = sb.sputc(char((n->left ? 1 : 0) | (n->right ? 2 : 0))) != EOF and
+      BinTreeCodec<T>::write(sb, n->x);
+    if (n->right) pending.push_back(n->right.get());
+    if (n->left) pending.push_back(n->left.get());
+  }
+  if (not ok) os.setstate(ios::badbit);
+}
+
+template <class T>
+void BinTree<T>::readBinary(std::istream &is, BinTree<T> &t)
+{
+  streambuf &sb = *is.rdbuf();
+  unsigned long long size;
+  checkFormatCondition(BinTreeNumber::read(sb, size));
+  // Places where the next nodes go, the next one on top. The nodes are
+  // created empty and their values are read straight into them.
+  shared_ptr<Node> root;
+  vector<shared_ptr<Node>*> slots;
+  if (size > 0) slots.push_back(&root);
+  for (; size > 0; --size) {
+    checkFormatCondition(not slots.empty());
+    int shape = sb.sbumpc();
+    checkFormatCondition(0 <= shape and shape <= 3);
+    shared_ptr<Node> &slot = *slots.back();
+    slots.pop_back();
+    slot = make_shared<Node>(T(), nullptr, nullptr);
+    checkFormatCondition(BinTreeCodec<T>::read(sb, slot->x));
+    if (shape & 2) slots.push_back(&slot->right);
+    if (shape & 1) slots.push_back(&slot->left);
+  }
+  checkFormatCondition(slots.empty());
+  t.p = move(root);
+}
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 ////////////////////////////////////////
@@ -672,6 +1060,10 @@ vector<string> BinTree<T>::generateVisualFormat(const BinTree<T> &t) {
 template <class T>
 std::ostream& operator<<(std::ostream &os, const BinTree<T> &t) {
   int format = t.getOutputFormat();
+  if (format == BinTree<T>::BINARYFORMAT) {
+    BinTree<T>::writeBinary(os, t);
+    return os;
+  }
   if (format == BinTree<T>::INLINEFORMAT) {
     BinTree<T>::writeStringTree(os, t);
     return os;
@@ -702,6 +1094,12 @@ template <class T>
 std::istream& operator>>(std::istream &is, BinTree<T> &t) {
   int inputformat = t.getInputFormat();
   int outputformat = t.getOutputFormat();
+  if (inputformat == BinTree<T>::BINARYFORMAT) {
+    BinTree<T>::readBinary(is, t);
+    t.setInputFormat(inputformat);
+    t.setOutputFormat(outputformat);
+    return is;
+  }
   if (inputformat == BinTree<T>::INLINEFORMAT) {
     string s;
     is >> s;
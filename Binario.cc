@@ -0,0 +1,177 @@
+/** @file Binario.cc
+    @brief Código de las clases Escritor_binario y Lector_binario.
+*/
+
+#include "Binario.hh"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <algorithm>
+
+// Bloques grandes: la lectura y escritura de un estado queda limitada por el disco.
+static const size_t TAM_BUFER = 1 << 20;
+
+// Escritor_binario
+
+// Pre: cierto.
+// Post: El escritor está en estado de error si no se ha podido crear.
+
+Escritor_binario::Escritor_binario(const string& fichero) : _buf(TAM_BUFER), _n(0) {
+    _fd = open(fichero.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    _ok = _fd >= 0;
+}
+
+// Pre: cierto.
+// Post: Se ha cerrado el fichero, si seguía abierto.
+
+Escritor_binario::~Escritor_binario() {
+    if (_fd >= 0) close(_fd);
+}
+
+// Pre: cierto.
+// Post: El búfer está vacío.
+
+void Escritor_binario::volcar() {
+    size_t hecho = 0;
+    while (_ok and hecho < _n) {
+        ssize_t k = write(_fd, _buf.data() + hecho, _n - hecho);
+        if (k < 0 and errno == EINTR) continue;
+        if (k <= 0) _ok = false;
+        else hecho += k;
+    }
+    _n = 0;
+}
+
+// Pre: cierto.
+// Post: Se han escrito los n bytes de p.
+
+void Escritor_binario::bytes(const void* p, size_t n) {
+    const char* q = (const char*)p;
+    while (_ok and n > 0) {
+        if (_n == _buf.size()) volcar();
+        size_t k = min(n, _buf.size() - _n);
+        memcpy(_buf.data() + _n, q, k);
+        _n += k;
+        q += k;
+        n -= k;
+    }
+}
+
+// Pre: cierto.
+// Post: Devuelve cierto si todo el contenido se ha escrito correctamente.
+
+bool Escritor_binario::cerrar() {
+    if (_fd < 0) return false;
+    volcar();
+    if (fsync(_fd) < 0) _ok = false;
+    if (close(_fd) < 0) _ok = false;
+    _fd = -1;
+    return _ok;
+}
+
+// Lector_binario
+
+// Pre: cierto.
+// Post: El lector está en estado de error si no se ha podido abrir.
+
+Lector_binario::Lector_binario(const string& fichero) : _buf(TAM_BUFER), _datos(_buf.data()), _pos(0), _fin(0), _quedan(0) {
+    _fd = open(fichero.c_str(), O_RDONLY);
+    struct stat st;
+    _ok = _fd >= 0 and fstat(_fd, &st) == 0;
+    if (_ok) {
+        _quedan = st.st_size;
+        posix_fadvise(_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+}
+
+// Pre: datos no se libera ni se modifica mientras se usa el lector.
+// Post: El lector devuelve el contenido de datos como si fuera un fichero.
+
+Lector_binario::Lector_binario(const char* datos, size_t n) : _datos(datos), _pos(0), _fin(n), _fd(-1), _ok(true), _quedan(n) {}
+
+// Pre: cierto.
+// Post: Se ha cerrado el fichero.
+
+Lector_binario::~Lector_binario() {
+    if (_fd >= 0) close(_fd);
+}
+
+// Pre: El búfer está consumido.
+// Post: Devuelve falso si no quedaban datos.
+
+bool Lector_binario::recargar() {
+    if (_fd < 0) return false;
+    ssize_t k;
+    do {
+        k = read(_fd, _buf.data(), _buf.size());
+    } while (k < 0 and errno == EINTR);
+    _pos = 0;
+    _fin = k > 0 ? k : 0;
+    return k > 0;
+}
+
+// Pre: cierto.
+// Post: Se han leído n bytes en p; si no quedaban, p se rellena con ceros y
+// el lector pasa a estado de error.
+
+void Lector_binario::bytes(void* p, size_t n) {
+    char* q = (char*)p;
+    while (n > 0) {
+        if (not _ok or (_pos == _fin and not recargar())) {
+            _ok = false;
+            memset(q, 0, n);
+            return;
+        }
+        size_t k = min(n, _fin - _pos);
+        memcpy(q, _datos + _pos, k);
+        _pos += k;
+        _quedan -= min(k, _quedan);
+        q += k;
+        n -= k;
+    }
+}
+
+// Pre: cierto.
+// Post: Devuelve el string leído.
+
+string Lector_binario::cadena() {
+    int n = entero();
+    if (n < 0 or not quedan(n)) {
+        _ok = false;
+        return string();
+    }
+    string s(n, ' ');
+    if (n > 0) bytes(&s[0], n);
+    return s;
+}
+
+// Pre: cierto.
+// Post: Devuelve cierto si quedan al menos n bytes por leer en el fichero.
+// Si no, el lector pasa a estado de error.
+
+bool Lector_binario::quedan(size_t n) {
+    if (n > _quedan) _ok = false;
+    return _ok;
+}
+
+// Pre: cierto.
+// Post: Devuelve falso si no se ha podido leer. Si no, datos es el contenido
+// del fichero.
+
+bool Lector_binario::leer_todo(const string& fichero, vector<char>& datos) {
+    int fd = open(fichero.c_str(), O_RDONLY);
+    struct stat st;
+    bool ok = fd >= 0 and fstat(fd, &st) == 0;
+    if (ok) datos.resize(st.st_size);
+    size_t hecho = 0;
+    while (ok and hecho < datos.size()) {
+        ssize_t k = read(fd, datos.data() + hecho, datos.size() - hecho);
+        if (k < 0 and errno == EINTR) continue;
+        if (k <= 0) ok = false;
+        else hecho += k;
+    }
+    if (fd >= 0) close(fd);
+    return ok;
+}
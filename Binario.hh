@@ -0,0 +1,177 @@
+/** @file Binario.hh
+    @brief Especificación de las clases Escritor_binario y Lector_binario.
+*/
+
+#ifndef _BINARIO_HH_
+#define _BINARIO_HH_
+
+#ifndef NO_DIAGRAM
+#include <string>
+#include <vector>
+#include <cstring>
+#endif
+
+using namespace std;
+
+/** @class Escritor_binario
+    @brief Escritura secuencial de un fichero binario a través de un búfer grande.
+
+    Los enteros se escriben con su representación nativa de 4 bytes y los
+    strings con su longitud delante. Si alguna escritura falla el escritor
+    queda en estado de error y las siguientes se ignoran.
+*/
+
+class Escritor_binario
+{
+
+private:
+  /** @brief Búfer de escritura. */
+  vector<char> _buf;
+  /** @brief Número de bytes pendientes de escribir. */
+  size_t _n;
+  /** @brief Descriptor del fichero, -1 si no está abierto. */
+  int _fd;
+  /** @brief Cierto si todas las escrituras han ido bien. */
+  bool _ok;
+
+  /** @brief Escribe el búfer en el fichero.
+      \pre <em>cierto</em>
+      \post El búfer está vacío.
+  */
+  void volcar();
+
+public:
+  // Constructora
+
+  /** @brief Crea el fichero indicado, vaciándolo si ya existía.
+      \pre <em>cierto</em>
+      \post El escritor está en estado de error si no se ha podido crear.
+  */
+  explicit Escritor_binario(const string& fichero);
+
+  /** @brief Destructora.
+      \pre <em>cierto</em>
+      \post Se ha cerrado el fichero, si seguía abierto.
+  */
+  ~Escritor_binario();
+
+  // Modificadoras
+
+  /** @brief Escribe n bytes. */
+  void bytes(const void* p, size_t n);
+
+  /** @brief Escribe un entero. */
+  void entero(int x) {
+    bytes(&x, sizeof(x));
+  }
+
+  /** @brief Escribe un string precedido de su longitud. */
+  void cadena(const string& s) {
+    entero(s.size());
+    bytes(s.data(), s.size());
+  }
+
+  /** @brief Escribe lo pendiente, lo lleva a disco y cierra el fichero.
+      \pre <em>cierto</em>
+      \post Devuelve cierto si todo el contenido se ha escrito correctamente.
+  */
+  bool cerrar();
+};
+
+/** @class Lector_binario
+    @brief Lectura secuencial de un fichero binario a través de un búfer grande.
+
+    Lee lo escrito por un Escritor_binario, de un fichero o de una copia suya
+    en memoria. Si el fichero se acaba antes de
+    tiempo el lector queda en estado de error y devuelve ceros. Las longitudes
+    leídas se comprueban contra lo que queda del fichero antes de reservar
+    memoria, de modo que un fichero corrupto no pide más de lo que ocupa.
+*/
+
+class Lector_binario
+{
+
+private:
+  /** @brief Búfer de lectura. */
+  vector<char> _buf;
+  /** @brief Datos por consumir: el búfer, o la copia en memoria. */
+  const char* _datos;
+  /** @brief Posición del siguiente byte por consumir. */
+  size_t _pos;
+  /** @brief Número de bytes válidos en el búfer. */
+  size_t _fin;
+  /** @brief Descriptor del fichero, -1 si no está abierto. */
+  int _fd;
+  /** @brief Cierto si todas las lecturas han ido bien. */
+  bool _ok;
+  /** @brief Bytes del fichero aún no consumidos. */
+  size_t _quedan;
+
+  /** @brief Lee el siguiente bloque del fichero.
+      \pre El búfer está consumido.
+      \post Devuelve falso si no quedaban datos.
+  */
+  bool recargar();
+
+public:
+  // Constructora
+
+  /** @brief Abre el fichero indicado.
+      \pre <em>cierto</em>
+      \post El lector está en estado de error si no se ha podido abrir.
+  */
+  explicit Lector_binario(const string& fichero);
+
+  /** @brief Lee de los n bytes que empiezan en datos.
+      \pre datos no se libera ni se modifica mientras se usa el lector.
+      \post El lector devuelve el contenido de datos como si fuera un fichero.
+  */
+  Lector_binario(const char* datos, size_t n);
+
+  /** @brief Destructora.
+      \pre <em>cierto</em>
+      \post Se ha cerrado el fichero.
+  */
+  ~Lector_binario();
+
+  /** @brief Lee un fichero entero.
+      \pre <em>cierto</em>
+      \post Devuelve falso si no se ha podido leer. Si no, datos es el
+      contenido del fichero.
+  */
+  static bool leer_todo(const string& fichero, vector<char>& datos);
+
+  // Lectura
+
+  /** @brief Lee n bytes. */
+  void bytes(void* p, size_t n);
+
+  /** @brief Lee un entero. */
+  int entero() {
+    int x = 0;
+    bytes(&x, sizeof(x));
+    return x;
+  }
+
+  /** @brief Lee un string precedido de su longitud. */
+  string cadena();
+
+  /** @brief Comprueba una longitud leída.
+      \pre <em>cierto</em>
+      \post Devuelve cierto si quedan al menos n bytes por leer en el fichero.
+      Si no, el lector pasa a estado de error.
+  */
+  bool quedan(size_t n);
+
+  // Consultoras
+
+  /** @brief Consultora de estado.
+      \pre <em>cierto</em>
+      \post Devuelve cierto si todas las lecturas han ido bien.
+  */
+  bool ok() const {
+    return _ok;
+  }
+};
+
+#endif
@@ -3,6 +3,7 @@
 */
 
 #include "Ciudad.hh"
+#include "Nucleos_comercio.hh"
 
 // Constructora
 
@@ -12,6 +13,108 @@
 Ciudad::Ciudad() {
     _peso_total = 0;
     _volumen_total = 0;
+    _obs = nullptr;
+    _id = -1;
+}
+
+// Observación
+
+// Pre: cierto.
+// Post: Si hay observador, se le ha avisado de cada producto del
+// inventario, en orden de ID.
+
+void Ciudad::avisar_inventario() const {
+    if (_obs == nullptr) return;
+    for (int i = 0; i < int(_ids.size()); ++i) avisar(i);
+}
+
+// Pre: cierto.
+// Post: Se ha avisado a obs de cada producto del inventario, en orden de ID y
+// con el identificador de la ciudad.
+
+void Ciudad::avisar_inventario(Observador& obs) const {
+    for (int i = 0; i < int(_ids.size()); ++i) obs.producto_cambiado(_id, _ids[i], true, _tiene[i], _necesita[i]);
+}
+
+// Inventario
+
+// Pre: cierto.
+// Post: Devuelve la primera posición i tal que _ids[i] >= id_producto.
+
+int Ciudad::posicion(int id_producto) const {
+    return lower_bound(_ids.begin(), _ids.end(), id_producto) - _ids.begin();
+}
+
+// Pre: cierto.
+// Post: Devuelve la posición del producto en _ids, o -1 si no está.
+
+int Ciudad::buscar(int id_producto) const {
+    int i = posicion(id_producto);
+    return (i < int(_ids.size()) and _ids[i] == id_producto) ? i : -1;
+}
+
+// Pre: cierto.
+// Post: El producto tiene los datos indicados, y devuelve las unidades
+// que poseía antes (0 si no estaba).
+
+int Ciudad::asignar(int id_producto, int prod_tiene, int prod_necesita) {
+    int i = posicion(id_producto);
+    int anterior = 0;
+    if (i < int(_ids.size()) and _ids[i] == id_producto) {
+        anterior = _tiene[i];
+    }
+    else {
+        _ids.insert(_ids.begin() + i, id_producto);
+        _tiene.insert(_tiene.begin() + i, 0);
+        _necesita.insert(_necesita.begin() + i, 0);
+    }
+    _tiene[i] = prod_tiene;
+    _necesita[i] = prod_necesita;
+    avisar(i);
+    return anterior;
+}
+
+// Pre: 0 <= i < _ids.size().
+// Post: El producto de la posición i ya no está y se ha avisado de ello.
+
+void Ciudad::borrar(int i) {
+    int id_producto = _ids[i];
+    _ids.erase(_ids.begin() + i);
+    _tiene.erase(_tiene.begin() + i);
+    _necesita.erase(_necesita.begin() + i);
+    avisar_quitado(id_producto);
+}
+
+// Pre: Los vectores del inventario tienen el mismo tamaño.
+// Post: El inventario está ordenado por ID sin repetidos; de un ID repetido
+// se conservan los datos de su última aparición.
+
+void Ciudad::ordenar_inventario() {
+    int n = _ids.size();
+    vector<int> orden(n);
+    for (int i = 0; i < n; ++i) orden[i] = i;
+    const vector<int>& ids = _ids;
+    stable_sort(orden.begin(), orden.end(), [&ids](int a, int b) { return ids[a] < ids[b]; });
+
+    vector<int> ids2, tiene2, necesita2;
+    ids2.reserve(n);
+    tiene2.reserve(n);
+    necesita2.reserve(n);
+    for (int k = 0; k < n; ++k) {
+        int i = orden[k];
+        if (not ids2.empty() and ids2.back() == _ids[i]) {
+            tiene2.back() = _tiene[i];
+            necesita2.back() = _necesita[i];
+        }
+        else {
+            ids2.push_back(_ids[i]);
+            tiene2.push_back(_tiene[i]);
+            necesita2.push_back(_necesita[i]);
+        }
+    }
+    _ids.swap(ids2);
+    _tiene.swap(tiene2);
+    _necesita.swap(necesita2);
 }
 
 // Modificadoras
@@ -22,13 +125,17 @@ Ciudad::Ciudad() {
 void Ciudad::vender_prod(int id_producto, int vendidos, const Cjt_productos& cp) {
     _peso_total -= cp.consultar_peso_producto(id_producto) * vendidos;
     _volumen_total -= cp.consultar_volumen_producto(id_producto)* vendidos;
-    auto it = _inv.find(id_producto); // Verificamos producto en ciudad.
-    if (it != _inv.end()) {
-        it->second._prod_tiene -= vendidos;
-        if (it->second._prod_necesita == 0 and it->second._prod_necesita == 0) {
-            _inv.erase(id_producto); // Si no tiene ni necesita, lo borramos.
+    int i = buscar(id_producto); // Verificamos producto en ciudad.
+    if (i >= 0) {
+        _tiene[i] -= vendidos;
+        if (_necesita[i] == 0 and _necesita[i] == 0) {
+            borrar(i); // Si no tiene ni necesita, lo borramos.
+        }
+        else {
+            avisar(i);
         }
     }
+    avisar_totales();
 }
 
 // Pre: cierto.
@@ -37,10 +144,12 @@ void Ciudad::vender_prod(int id_producto, int vendidos, const Cjt_productos& cp)
 void Ciudad::comprar_prod(int id_producto, int comprados, const Cjt_productos& cp) {
     _peso_total += cp.consultar_peso_producto(id_producto) * comprados;
     _volumen_total += cp.consultar_volumen_producto(id_producto)* comprados;
-    auto it = _inv.find(id_producto);
-    if (it != _inv.end()) { // Verificamos producto en ciudad.
-        it->second._prod_tiene += comprados;
+    int i = buscar(id_producto);
+    if (i >= 0) { // Verificamos producto en ciudad.
+        _tiene[i] += comprados;
+        avisar(i);
     }
+    avisar_totales();
 }
 
 // Pre: prod_tiene + prod_necesita > 0.
@@ -48,16 +157,14 @@ void Ciudad::comprar_prod(int id_producto, int comprados, const Cjt_productos& c
 // Se escribe el peso y volumen total.
 
 void Ciudad::poner_prod(int id_producto, int prod_tiene, int prod_necesita, const Cjt_productos& cp) {
-    inventario inv;
     // Verificamos errores en función de cuenca.
 
     _peso_total += cp.consultar_peso_producto(id_producto) * prod_tiene;
     _volumen_total += cp.consultar_volumen_producto(id_producto) * prod_tiene;
-    inv._prod_tiene = prod_tiene;
-    inv._prod_necesita = prod_necesita;
-    _inv[id_producto] = inv;
+    asignar(id_producto, prod_tiene, prod_necesita);
+    avisar_totales();
 
-    cout << _peso_total << ' ' << _volumen_total << endl;
+    salida << _peso_total << ' ' << _volumen_total << '\n';
 }
 
 // Pre: prod_tiene + prod_necesita > 0.
@@ -65,20 +172,18 @@ void Ciudad::poner_prod(int id_producto, int prod_tiene, int prod_necesita, cons
 // Se escribe el peso y volumen total.
 
 void Ciudad::modificar_prod(int id_producto, int prod_tiene, int prod_necesita, const Cjt_productos& cp) {
-    inventario inv;
     // Verificamos errores en función de cuenca.
     int volumen = cp.consultar_volumen_producto(id_producto);
     int peso = cp.consultar_peso_producto(id_producto);
 
-    _peso_total -= peso * _inv[id_producto]._prod_tiene;
-    _volumen_total -= volumen * _inv[id_producto]._prod_tiene;
+    int anterior = asignar(id_producto, prod_tiene, prod_necesita);
+    _peso_total -= peso * anterior;
+    _volumen_total -= volumen * anterior;
     _peso_total += peso * prod_tiene;
     _volumen_total += volumen * prod_tiene;
-    inv._prod_tiene = prod_tiene;
-    inv._prod_necesita = prod_necesita;
-    _inv[id_producto] = inv;
+    avisar_totales();
 
-    cout << _peso_total << ' ' << _volumen_total << endl;
+    salida << _peso_total << ' ' << _volumen_total << '\n';
 }
 
 // Pre: cierto.
@@ -87,11 +192,15 @@ void Ciudad::modificar_prod(int id_producto, int prod_tiene, int prod_necesita,
 
 void Ciudad::quitar_prod(int id_producto, const Cjt_productos& cp) {
     // Verificamos errores en función de cuenca.
-    _peso_total -= cp.consultar_peso_producto(id_producto) * _inv[id_producto]._prod_tiene;
-    _volumen_total -= cp.consultar_volumen_producto(id_producto) * _inv[id_producto]._prod_tiene;
-    _inv.erase(id_producto);
+    int i = buscar(id_producto);
+    if (i >= 0) {
+        _peso_total -= cp.consultar_peso_producto(id_producto) * _tiene[i];
+        _volumen_total -= cp.consultar_volumen_producto(id_producto) * _tiene[i];
+        borrar(i);
+        avisar_totales();
+    }
 
-    cout << _peso_total << ' ' << _volumen_total << endl;
+    salida << _peso_total << ' ' << _volumen_total << '\n';
 }
 
 // Pre: El parámetro implícito y la ciudad c2 están correctamente inicializados y sus inventarios
@@ -103,56 +212,115 @@ void Ciudad::quitar_prod(int id_producto, const Cjt_productos& cp) {
 // Los atributos de peso y volumen total de ambas ciudades se han ajustado adecuadamente.
 
 void Ciudad::comerciar(Ciudad& c2, const Cjt_productos& cp) {
-    auto it1 = _inv.begin(); // Iterador para la primera ciudad.
-    auto it2 = c2._inv.begin(); // Iterador para la segunda ciudad.
-    
+    int n1 = _ids.size();
+    int n2 = c2._ids.size();
+    if (n1 >= MIN_BLOQUES and n2 >= MIN_BLOQUES and comerciar_bloques(c2, cp)) return;
+    int i = 0; // Posición en la primera ciudad.
+    int j = 0; // Posición en la segunda ciudad.
+    bool cambiado = false;
+
     // Recorremos ambos inventarios simultáneamente.
-    while (it1 != _inv.end() and it2 != c2._inv.end()) {
+    while (i < n1 and j < n2) {
+        int id1 = _ids[i];
+        int id2 = c2._ids[j];
         // Si los productos coinciden en ambos inventarios:
-        if (it1->first == it2->first) {
-            int excedente1 = it1->second._prod_tiene - it1->second._prod_necesita;
-            int excedente2 = it2->second._prod_tiene - it2->second._prod_necesita;
+        if (id1 == id2) {
+            int excedente1 = _tiene[i] - _necesita[i];
+            int excedente2 = c2._tiene[j] - c2._necesita[j];
 
-            // Si a la primera ciudad le sobran y a la segunda le faltan:
-            if (excedente1 > 0 and excedente2 < 0) {
-                // Actualizamos los inventarios y atributos de ambas ciudades
-                int min_balance = min(excedente1, abs(excedente2));
-                it1->second._prod_tiene -= min_balance;
-                it2->second._prod_tiene += min_balance;
-                int volumen = cp.consultar_volumen_producto(it1->first);
-                int peso = cp.consultar_peso_producto(it1->first);
-
-                _peso_total -= min_balance * peso;
-                _volumen_total -= min_balance * volumen;
-                c2._peso_total += min_balance * peso;
-                c2._volumen_total += min_balance * volumen;
-            }
-            // Si a la primera ciudad le faltan y a la segunda le sobran:
-            else if (excedente1 < 0 and excedente2 > 0) {
+            // Solo hay intercambio si a una ciudad le sobran y a la otra le faltan.
+            // min_balance > 0 si la primera ciudad da, < 0 si recibe.
+            int min_balance = 0;
+            if (excedente1 > 0 and excedente2 < 0) min_balance = min(excedente1, -excedente2);
+            else if (excedente1 < 0 and excedente2 > 0) min_balance = -min(-excedente1, excedente2);
+
+            if (min_balance != 0) {
                 // Actualizamos los inventarios y atributos de ambas ciudades
-                int min_balance = min(abs(excedente1), excedente2);
-                it2->second._prod_tiene -= min_balance;
-                it1->second._prod_tiene += min_balance;
-                int volumen = cp.consultar_volumen_producto(it1->first);
-                int peso = cp.consultar_peso_producto(it1->first);
-
-                c2._peso_total -= min_balance * peso;
-                c2._volumen_total -= min_balance * volumen;
-                _peso_total += min_balance * peso;
-                _volumen_total += min_balance * volumen;
+                _tiene[i] -= min_balance;
+                c2._tiene[j] += min_balance;
+                int peso = cp.consultar_peso_producto(id1) * min_balance;
+                int volumen = cp.consultar_volumen_producto(id1) * min_balance;
+
+                _peso_total -= peso;
+                _volumen_total -= volumen;
+                c2._peso_total += peso;
+                c2._volumen_total += volumen;
+                avisar(i);
+                c2.avisar(j);
+                cambiado = true;
             }
-            ++it1; // Avanzamos ambos iteradores.
-            ++it2;
+            ++i; // Avanzamos ambas posiciones.
+            ++j;
         }
-        // Si la ID del producto de la primera ciudad es menor que el de la segunda, avanzamos el iterador de la primera.
-        else if (it1->first < it2->first) {
-            ++it1;
+        // Si la ID del producto de la primera ciudad es menor, avanzamos en la primera.
+        else if (id1 < id2) {
+            ++i;
         }
-        // Si la ID del producto de la segunda ciudad es menor que el de la segunda, avanzamos el iterador de la segunda.
+        // Si no, avanzamos en la segunda.
         else {
-            ++it2;
+            ++j;
         }
     }
+    if (cambiado) {
+        avisar_totales();
+        c2.avisar_totales();
+    }
+}
+
+// Pre: Las de comerciar().
+// Post: Si no compensa comerciar por bloques, devuelve falso y no ha cambiado
+// nada. Si no, las de comerciar() y devuelve cierto.
+
+bool Ciudad::comerciar_bloques(Ciudad& c2, const Cjt_productos& cp) {
+    Vista_inventario a = { _ids.data(), _tiene.data(), _necesita.data(), int(_ids.size()) };
+    Vista_inventario b = { c2._ids.data(), c2._tiene.data(), c2._necesita.data(), int(c2._ids.size()) };
+    if (not por_bloques(a, b)) return false;
+
+    // Memoria de trabajo de cada hilo, para no reservarla en cada comercio.
+    static thread_local vector<int> posiciones, balances, productos;
+    int m = min(_ids.size(), c2._ids.size()) + HOLGURA;
+    if (int(balances.size()) < m) {
+        posiciones.resize(2*m);
+        balances.resize(m);
+        productos.resize(3*m);
+    }
+    int* pos1 = posiciones.data();
+    int* pos2 = pos1 + m;
+    int* balance = balances.data();
+    int* ids = productos.data();
+    int* pesos = ids + m;
+    int* volumenes = pesos + m;
+
+    // Productos comunes con intercambio: > 0 si la primera ciudad da, < 0 si recibe.
+    int k = intercambios(a, b, pos1, pos2, balance);
+
+    // Los pesos y volúmenes de todos los productos intercambiados, de una vez.
+    for (int t = 0; t < k; ++t) ids[t] = _ids[pos1[t]];
+    cp.consultar_pesos_volumenes(ids, k, pesos, volumenes);
+
+    // Transferencias, con los pesos y volúmenes acumulados.
+    int peso = 0;
+    int volumen = 0;
+    for (int t = 0; t < k; ++t) {
+        int b = balance[t];
+        int i = pos1[t];
+        int j = pos2[t];
+        _tiene[i] -= b;
+        c2._tiene[j] += b;
+        peso += pesos[t] * b;
+        volumen += volumenes[t] * b;
+        avisar(i);
+        c2.avisar(j);
+    }
+    _peso_total -= peso;
+    _volumen_total -= volumen;
+    c2._peso_total += peso;
+    c2._volumen_total += volumen;
+    if (k > 0) {
+        avisar_totales();
+        c2.avisar_totales();
+    }
+    return true;
 }
   
 // Consultoras
@@ -161,36 +329,37 @@ void Ciudad::comerciar(Ciudad& c2, const Cjt_productos& cp) {
 // Post: Devuelve cuántas unidades de ese producto tiene la ciudad.
 
 int Ciudad::consultar_tiene_ciudad(int id_producto) const {
-    return _inv.at(id_producto)._prod_tiene;
+    return _tiene[buscar(id_producto)];
 }
 
 // Pre: El producto pertenece a la ciudad.
 // Post: Devuelve cuántas unidades de ese producto necesita la ciudad.
 
 int Ciudad::consultar_necesita_ciudad(int id_producto) const {
-    return _inv.at(id_producto)._prod_necesita;
+    return _necesita[buscar(id_producto)];
 }
 
 // Pre: El producto pertenece a la ciudad.
 // Post: Devuelve cuántas unidades de ese producto tiene y necesita la ciudad.
 
 void Ciudad::consultar_prod_ciudad(int id_producto) const {
-    auto it = _inv.find(id_producto);
-    cout << it->second._prod_tiene << ' ' << it->second._prod_necesita << endl;
+    int i = buscar(id_producto);
+    salida << _tiene[i] << ' ' << _necesita[i] << '\n';
 }
 
 // Pre: El producto pertenece a la ciudad.
 // Post: Devuelve cuántas unidades de ese producto tiene la ciudad menos las que necesita.
 
 int Ciudad::consultar_necesitareal_ciudad(int id_producto) const {
-    return _inv.at(id_producto)._prod_tiene - _inv.at(id_producto)._prod_necesita;
+    int i = buscar(id_producto);
+    return _tiene[i] - _necesita[i];
 }
 
 // Pre: cierto.
 // Post: Devuelve true si el producto está en el inventario, falso de lo contrario.
 
 bool Ciudad::hay_prod_ciudad(int id_producto) const {
-    return _inv.find(id_producto) != _inv.end();
+    return buscar(id_producto) >= 0;
 }
 
 // Escritura
@@ -199,37 +368,97 @@ bool Ciudad::hay_prod_ciudad(int id_producto) const {
 // Post: Se ha escrito el inventario, peso y volumen total de la ciudad por el canal estándard de salida.
 
 void Ciudad::escribir_ciudad() const {
-    for (auto it = _inv.begin(); it != _inv.end(); ++it) {
-        cout << it->first << ' ' << it->second._prod_tiene << ' ' << it->second._prod_necesita << endl;
+    for (int i = 0; i < int(_ids.size()); ++i) {
+        salida << _ids[i] << ' ' << _tiene[i] << ' ' << _necesita[i] << '\n';
     }
-    cout << _peso_total << ' ' << _volumen_total << endl;
+    salida << _peso_total << ' ' << _volumen_total << '\n';
 }
 
 
 // Lectura
 
-// Pre: En el canal estándar de entrada se encuentra un entero no negativo.
+// Pre: En el lector in se encuentra un entero no negativo.
 // Posteriormente, se leen tres enteros el número de veces indicado por el anterior entero, 
 // todos estrictamente positivos excepto el segundo que puede ser cero.
 // Post: Se ha leído el inventario de la ciudad.
-void Ciudad::leer_inventario(const Cjt_productos& cp) {
-    _inv.clear(); // Limpiamos el inventario anterior.
-    _peso_total = 0; // Reiniciamos el peso y volumen total.
-    _volumen_total = 0;
+void Ciudad::leer_inventario(const Cjt_productos& cp, Lector& in) {
+    for (int i = 0; i < int(_ids.size()); ++i) avisar_quitado(_ids[i]);
 
-    int num_elem;
-    cin >> num_elem;
+    int num_elem = in.leer_entero();
+    _ids.resize(num_elem);
+    _tiene.resize(num_elem);
+    _necesita.resize(num_elem);
 
+    // Se leen directamente sobre los vectores; lo normal es que vengan en orden.
+    bool ordenado = true;
     for (int i = 0; i < num_elem; ++i) {
-        int id_producto, prod_tiene, prod_necesita;
-        cin >> id_producto >> prod_tiene >> prod_necesita;
-
-        _peso_total += cp.consultar_peso_producto(id_producto) * prod_tiene;
-        _volumen_total += cp.consultar_volumen_producto(id_producto) * prod_tiene;
-        
-        inventario inv;
-        inv._prod_tiene = prod_tiene;
-        inv._prod_necesita = prod_necesita;
-        _inv[id_producto] = inv;
-    }
-}
\ No newline at end of file
+        int id_producto = in.leer_entero();
+        int prod_tiene = in.leer_entero();
+        int prod_necesita = in.leer_entero();
+        ordenado = ordenado and (i == 0 or _ids[i - 1] < id_producto);
+        _ids[i] = id_producto;
+        _tiene[i] = prod_tiene;
+        _necesita[i] = prod_necesita;
+    }
+
+    // Peso y volumen total de todo lo leído, con los de todos los productos
+    // consultados de una vez.
+    static thread_local vector<int> pesos, volumenes;
+    if (int(pesos.size()) < num_elem) {
+        pesos.resize(num_elem);
+        volumenes.resize(num_elem);
+    }
+    cp.consultar_pesos_volumenes(_ids.data(), num_elem, pesos.data(), volumenes.data());
+    _peso_total = 0;
+    _volumen_total = 0;
+    for (int i = 0; i < num_elem; ++i) {
+        _peso_total += pesos[i] * _tiene[i];
+        _volumen_total += volumenes[i] * _tiene[i];
+    }
+    if (not ordenado) ordenar_inventario();
+    avisar_inventario();
+    avisar_totales();
+}
+
+// Estado binario
+
+// Pre: cierto.
+// Post: Se han escrito en out el peso y volumen total y el inventario en orden de ID.
+
+void Ciudad::guardar(Escritor_binario& out) const {
+    out.entero(_peso_total);
+    out.entero(_volumen_total);
+    out.entero(_ids.size());
+    for (int i = 0; i < int(_ids.size()); ++i) {
+        out.entero(_ids[i]);
+        out.entero(_tiene[i]);
+        out.entero(_necesita[i]);
+    }
+}
+
+// Pre: En in se encuentra una ciudad escrita con guardar.
+// Post: El parámetro implícito pasa a tener el inventario, peso y volumen
+// leídos. Devuelve falso si algún producto no existe en cp o los IDs no son
+// estrictamente crecientes.
+
+bool Ciudad::cargar(Lector_binario& in, const Cjt_productos& cp) {
+    for (int i = 0; i < int(_ids.size()); ++i) avisar_quitado(_ids[i]);
+    _ids.clear();
+    _tiene.clear();
+    _necesita.clear();
+    _peso_total = in.entero();
+    _volumen_total = in.entero();
+    int num_elem = in.entero();
+    bool valido = true;
+    for (int i = 0; i < num_elem and in.ok() and valido; ++i) {
+        // Vienen ordenados por ID: se añaden al final.
+        int id_producto = in.entero();
+        valido = cp.hay_prod(id_producto) and (_ids.empty() or _ids.back() < id_producto);
+        _ids.push_back(id_producto);
+        _tiene.push_back(in.entero());
+        _necesita.push_back(in.entero());
+    }
+    avisar_inventario();
+    avisar_totales();
+    return valido;
+}
@@ -9,6 +9,7 @@
 
 #ifndef NO_DIAGRAM
 #include <cmath>
+#include <algorithm>
 #endif
 
 /** @class Ciudad
@@ -17,23 +18,128 @@
     Gestiona el inventario de productos, permitiendo la compra y venta de productos, 
     la modificación y eliminación de productos, y el comercio entre ciudades. Proporciona métodos 
     para consultar los productos que posee y necesita, así como el peso y volumen total de los productos.
+
+    El inventario se guarda en tres vectores paralelos ordenados por ID, de modo
+    que comerciar y escribir recorren memoria contigua y las consultas por ID se
+    resuelven con una búsqueda binaria. Para comerciar entre inventarios grandes
+    y densos los bloques de IDs comunes se resuelven con instrucciones
+    vectoriales.
 */
 
 class Ciudad
 {
 
-private:
-  /** @brief Struct de los productos que tiene y necesita */
-  struct inventario {
-    int _prod_tiene; // Número de productos que posee.
-    int _prod_necesita;  // Número de productos que precisa.
+public:
+  /** @brief Tamaño mínimo de los dos inventarios para comerciar por bloques. */
+  static const int MIN_BLOQUES = 32;
+
+  /** @brief Interfaz para enterarse de los cambios en el inventario de una ciudad.
+
+      Se avisa después de cada cambio, producto a producto, con el
+      identificador que se le dio a la ciudad en observar(). Al acabar cada
+      operación que cambia el peso o el volumen total se avisa también de
+      los nuevos totales.
+  */
+  class Observador {
+  public:
+    virtual ~Observador() {}
+
+    /** @brief Aviso de cambio de un producto.
+        \pre <em>cierto</em>
+        \post Se ha tenido en cuenta que el producto id_producto de la ciudad
+        ahora tiene y necesita las unidades indicadas o, si presente es falso,
+        que ya no está en su inventario.
+    */
+    virtual void producto_cambiado(int ciudad, int id_producto, bool presente, int tiene, int necesita) = 0;
+
+    /** @brief Aviso de cambio del peso y el volumen total.
+        \pre <em>cierto</em>
+        \post Se ha tenido en cuenta que la ciudad ahora tiene el peso y el
+        volumen total indicados. Por defecto no se hace nada.
+    */
+    virtual void totales_cambiados(int /* ciudad */, int /* peso */, int /* volumen */) {}
   };
-  /** @brief Conjunto ordenado de productos que relaciona ID con los productos que tiene y necesita. */
-  map<int, inventario> _inv;
+
+private:
+  /** @brief IDs de los productos del inventario, en orden creciente. */
+  vector<int> _ids;
+  /** @brief Número de unidades que posee de cada producto, en el orden de _ids. */
+  vector<int> _tiene;
+  /** @brief Número de unidades que precisa de cada producto, en el orden de _ids. */
+  vector<int> _necesita;
   /** @brief Peso total de los productos de la ciudad. */
   int _peso_total;
   /** @brief Volumen total de los productos de la ciudad. */
   int _volumen_total;
+  /** @brief A quién se avisa de los cambios, o nulo. */
+  Observador* _obs;
+  /** @brief Identificador de la ciudad en los avisos. */
+  int _id;
+
+  /** @brief Avisa del estado de un producto del inventario.
+      \pre 0 <= i < _ids.size().
+      \post Si hay observador, se le ha avisado del producto de la posición i.
+  */
+  void avisar(int i) const {
+    if (_obs != nullptr) _obs->producto_cambiado(_id, _ids[i], true, _tiene[i], _necesita[i]);
+  }
+
+  /** @brief Avisa del peso y el volumen total.
+      \pre <em>cierto</em>
+      \post Si hay observador, se le ha avisado de _peso_total y _volumen_total.
+  */
+  void avisar_totales() const {
+    if (_obs != nullptr) _obs->totales_cambiados(_id, _peso_total, _volumen_total);
+  }
+
+  /** @brief Avisa de que un producto ha salido del inventario.
+      \pre <em>cierto</em>
+      \post Si hay observador, se le ha avisado de que id_producto ya no está.
+  */
+  void avisar_quitado(int id_producto) const {
+    if (_obs != nullptr) _obs->producto_cambiado(_id, id_producto, false, 0, 0);
+  }
+
+  /** @brief Quita el producto de una posición del inventario.
+      \pre 0 <= i < _ids.size().
+      \post El producto de la posición i ya no está y se ha avisado de ello.
+  */
+  void borrar(int i);
+
+  /** @brief Posición de un producto en el inventario.
+      \pre <em>cierto</em>
+      \post Devuelve la primera posición i tal que _ids[i] >= id_producto.
+  */
+  int posicion(int id_producto) const;
+
+  /** @brief Búsqueda de un producto en el inventario.
+      \pre <em>cierto</em>
+      \post Devuelve la posición del producto en _ids, o -1 si no está.
+  */
+  int buscar(int id_producto) const;
+
+  /** @brief Pone un producto en el inventario.
+      \pre <em>cierto</em>
+      \post El producto tiene los datos indicados, y devuelve las unidades
+      que poseía antes (0 si no estaba).
+  */
+  int asignar(int id_producto, int prod_tiene, int prod_necesita);
+
+  /** @brief Ordena el inventario por ID.
+      \pre Los vectores del inventario tienen el mismo tamaño.
+      \post El inventario está ordenado por ID sin repetidos; de un ID repetido
+      se conservan los datos de su última aparición.
+  */
+  void ordenar_inventario();
+
+  /** @brief Operación de comerciar para inventarios grandes y densos.
+      \pre Las de comerciar().
+      \post Si no compensa comerciar por bloques (ver por_bloques()), devuelve
+      falso y no ha cambiado nada. Si no, las de comerciar() y devuelve cierto:
+      los intercambios se calculan por bloques con intercambios() y los pesos y
+      volúmenes se ajustan al final con la suma de las diferencias.
+  */
+  bool comerciar_bloques(Ciudad& c2, const Cjt_productos& cp);
 
 public:
   // Constructora
@@ -44,6 +150,31 @@ public:
       \post El resultado es una ciudad no inicializada.
   */   
   Ciudad();
+
+  // Observación
+
+  /** @brief Registra a quién avisar de los cambios del inventario.
+      \pre obs es nulo o sigue existiendo mientras se modifique la ciudad.
+      \post Los cambios siguientes se avisan a obs con el identificador id.
+  */
+  void observar(Observador* obs, int id) {
+    _obs = obs;
+    _id = id;
+  }
+
+  /** @brief Avisa de todo el inventario.
+      \pre <em>cierto</em>
+      \post Si hay observador, se le ha avisado de cada producto del
+      inventario, en orden de ID.
+  */
+  void avisar_inventario() const;
+
+  /** @brief Avisa de todo el inventario a otro observador.
+      \pre <em>cierto</em>
+      \post Se ha avisado a obs de cada producto del inventario, en orden de
+      ID y con el identificador de la ciudad, sin avisar al observador registrado.
+  */
+  void avisar_inventario(Observador& obs) const;
   
   // Modificadoras
 
@@ -122,6 +253,22 @@ public:
   */
   bool hay_prod_ciudad(int id_producto) const;
 
+  /** @brief Consultora del peso total.
+      \pre <em>cierto</em>
+      \post Devuelve el peso total de los productos de la ciudad.
+  */
+  int consultar_peso_total() const {
+    return _peso_total;
+  }
+
+  /** @brief Consultora del volumen total.
+      \pre <em>cierto</em>
+      \post Devuelve el volumen total de los productos de la ciudad.
+  */
+  int consultar_volumen_total() const {
+    return _volumen_total;
+  }
+
   // Escritura
 
   /** @brief Operación de escritura.
@@ -134,12 +281,28 @@ public:
   // Lectura
 
   /** @brief Operación de lectura.
-      \pre En el canal estándar de entrada se encuentra un entero no negativo.
+      \pre En el lector in se encuentra un entero no negativo.
       Posteriormente, se leen tres enteros el número de veces indicado por el anterior entero, 
       todos estrictamente positivos excepto el segundo que puede ser cero.
       \post Se ha leído el inventario de la ciudad.
   */
-  void leer_inventario(const Cjt_productos& cp);
+  void leer_inventario(const Cjt_productos& cp, Lector& in);
+
+  // Estado binario
+
+  /** @brief Guarda la ciudad en un estado binario.
+      \pre <em>cierto</em>
+      \post Se han escrito en out el peso y volumen total y el inventario en orden de ID.
+  */
+  void guardar(Escritor_binario& out) const;
+
+  /** @brief Carga la ciudad de un estado binario.
+      \pre En in se encuentra una ciudad escrita con guardar.
+      \post El parámetro implícito pasa a tener el inventario, peso y volumen
+      leídos. Devuelve falso si algún producto no existe en cp o los IDs no
+      son estrictamente crecientes.
+  */
+  bool cargar(Lector_binario& in, const Cjt_productos& cp);
 };
 
 #endif
\ No newline at end of file
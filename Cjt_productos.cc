@@ -11,17 +11,21 @@
 
 Cjt_productos::Cjt_productos() {
     _num_prod = 0;
+    _peso.push_back(0); // Posición 0 sin usar: las ID's empiezan en 1.
+    _volumen.push_back(0);
 }
 
-// Consultoras
-
-// Pre: Existe la id del producto.
-// Post Devuelve cierto si el producto existe, falso en caso contrario.
+// Pre: cierto.
+// Post: El producto p tiene la ID _num_prod + 1 y _num_prod se ha incrementado.
 
-bool Cjt_productos::hay_prod(int id_producto) const {
-    return _productos.find(id_producto) != _productos.end();
+void Cjt_productos::anadir(const Producto& p) {
+    _peso.push_back(p.consultar_peso());
+    _volumen.push_back(p.consultar_volumen());
+    _num_prod++;
 }
 
+// Consultoras
+
 // Pre: cierto.
 // Post: El resultado es el número de productos diferentes.
 
@@ -29,20 +33,16 @@ int Cjt_productos::consultar_num() const {
     return _num_prod;
 }
 
-// Pre: Existe la id del producto.
-// Post: Devuelve el peso del producto.
+// Pre: Existen las n ID's de ids; pesos y volumenes tienen espacio para n enteros.
+// Post: pesos[i] y volumenes[i] son el peso y el volumen del producto ids[i].
 
-int Cjt_productos::consultar_peso_producto(int id_producto) const {
-    auto it = _productos.find(id_producto);
-    return it->second.consultar_peso();
-}
-
-// Pre: Existe la id del producto.
-// Post Devuelve el volumen del producto.
-
-int Cjt_productos::consultar_volumen_producto(int id_producto) const {
-    auto it = _productos.find(id_producto);
-    return it->second.consultar_volumen();
+void Cjt_productos::consultar_pesos_volumenes(const int* ids, int n, int* pesos, int* volumenes) const {
+    const int* peso = _peso.data();
+    const int* volumen = _volumen.data();
+    for (int i = 0; i < n; ++i) {
+        pesos[i] = peso[ids[i]];
+        volumenes[i] = volumen[ids[i]];
+    }
 }
 
 // Escritura
@@ -53,27 +53,51 @@ int Cjt_productos::consultar_volumen_producto(int id_producto) const {
 
 void Cjt_productos::escribir_producto(int id_producto) const {
     if (hay_prod(id_producto)) {
-        cout << id_producto << ' ';
-        auto it = _productos.find(id_producto);
-        it->second.escribir_producto();
+        salida << id_producto << ' ' << _peso[id_producto] << ' ' << _volumen[id_producto] << '\n';
     } else {
-        cout << "error: no existe el producto" << endl;
+        salida << "error: no existe el producto\n";
     }
 }
 
 // Lectura
 
-// Pre: En el canal estándar de entrada se encuentran dos enteros
+// Pre: En el lector in se encuentran dos enteros
 // no negativos num_productos veces que representan el peso y volumen
 // de un producto. Los productos no podían existir anteriormente.
 // Post: Se han leído los nuevos productos.
 
-void Cjt_productos::agregar_productos(int num_productos) {
+void Cjt_productos::agregar_productos(int num_productos, Lector& in) {
+    _peso.reserve(_num_prod + 1 + max(num_productos, 0));
+    _volumen.reserve(_num_prod + 1 + max(num_productos, 0));
     for (int i = 0; i < num_productos; ++i) {
         Producto p;
-        p.leer_producto();
+        p.leer_producto(in);
         // Indexamos las ID's empezando por 1.
-        _productos[_num_prod+1] = p;
-        _num_prod++;
+        anadir(p);
     }
-}
\ No newline at end of file
+}
+
+// Estado binario
+
+// Pre: cierto.
+// Post: Se han escrito en out el número de productos y, en orden de ID, su peso y volumen.
+
+void Cjt_productos::guardar(Escritor_binario& out) const {
+    out.entero(_num_prod);
+    for (int id = 1; id <= _num_prod; ++id) {
+        out.entero(_peso[id]);
+        out.entero(_volumen[id]);
+    }
+}
+
+// Pre: El parámetro implícito está vacío. En in se encuentra un conjunto escrito con guardar.
+// Post: El parámetro implícito contiene los productos leídos.
+
+void Cjt_productos::cargar(Lector_binario& in) {
+    int num_productos = in.entero();
+    for (int i = 0; i < num_productos and in.ok(); ++i) {
+        Producto p;
+        p.cargar(in);
+        anadir(p);
+    }
+}
@@ -8,27 +8,37 @@
 #include "Producto.hh"
 
 #ifndef NO_DIAGRAM
-#include <map>
+#include <vector>
 #endif
 
 /** @class Cjt_productos
     @brief Representa un conjunto ordenado de productos identificados por una ID.
     
     Gestiona un conjunto de productos, permitiendo operaciones de consulta,
-    escritura y lectura. Los productos están identificados de manera única por un ID y se almacenan 
-    en un mapa para un acceso rápido. Proporciona métodos para verificar la existencia de productos, 
-    consultar sus atributos, y realizar la lectura y escritura de productos.
+    escritura y lectura. Los productos están identificados de manera única por un ID. Como los
+    ID's se asignan consecutivamente desde 1, los pesos y volúmenes se guardan en dos vectores
+    contiguos indexados por ID: consultar un producto es un acceso directo y comprobar que existe,
+    una comparación. Proporciona métodos para verificar la existencia de productos, 
+    consultar sus atributos (también de muchos a la vez), y realizar la lectura y escritura de productos.
 */
 
 class Cjt_productos
 {
 
 private:
-  /** @brief Conjunto ordenado por ID de los productos. */
-  map<int, Producto> _productos;
+  /** @brief Peso de cada producto, indexado por ID (la posición 0 no se usa). */
+  vector<int> _peso;
+  /** @brief Volumen de cada producto, indexado por ID (la posición 0 no se usa). */
+  vector<int> _volumen;
   /** @brief Número de productos que hay en el conjunto. */
   int _num_prod;
 
+  /** @brief Añade un producto al final del conjunto.
+      \pre <em>cierto</em>
+      \post El producto p tiene la ID _num_prod + 1 y _num_prod se ha incrementado.
+  */
+  void anadir(const Producto& p);
+
 public:
   // Constructora 
 
@@ -45,7 +55,9 @@ public:
       \pre Existe la id del producto.
       \post Devuelve cierto si el producto existe, falso en caso contrario
   */
-  bool hay_prod(int id_producto) const;
+  bool hay_prod(int id_producto) const {
+    return id_producto >= 1 and id_producto <= _num_prod;
+  }
 
  /** @brief Consultora del número de productos.
       \pre <em>cierto</em>
@@ -57,13 +69,23 @@ public:
       \pre Existe la id del producto.
       \post Devuelve el peso del producto.
   */
-  int consultar_peso_producto(int id_producto) const;
+  int consultar_peso_producto(int id_producto) const {
+    return _peso[id_producto];
+  }
 
   /** @brief Consultora del volumen de un producto.
       \pre Existe la id del producto.
       \post Devuelve el volumen del producto.
   */
-  int consultar_volumen_producto(int id_producto) const;
+  int consultar_volumen_producto(int id_producto) const {
+    return _volumen[id_producto];
+  }
+
+  /** @brief Consultora del peso y volumen de varios productos.
+      \pre Existen las n ID's de ids; pesos y volumenes tienen espacio para n enteros.
+      \post pesos[i] y volumenes[i] son el peso y el volumen del producto ids[i].
+  */
+  void consultar_pesos_volumenes(const int* ids, int n, int* pesos, int* volumenes) const;
 
   // Escritura
 
@@ -77,12 +99,26 @@ public:
   // Lectura
 
   /** @brief Operación de lectura.
-      \pre En el canal estándar de entrada se encuentran dos enteros
+      \pre En el lector in se encuentran dos enteros
       no negativos num_productos veces que representan el peso y volumen
       de un producto. Los productos no podían existir anteriormente.
       \post Se han leído los nuevos productos.
   */
-  void agregar_productos(int num_productos);
+  void agregar_productos(int num_productos, Lector& in);
+
+  // Estado binario
+
+  /** @brief Guarda el conjunto en un estado binario.
+      \pre <em>cierto</em>
+      \post Se han escrito en out el número de productos y, en orden de ID, su peso y volumen.
+  */
+  void guardar(Escritor_binario& out) const;
+
+  /** @brief Carga el conjunto de un estado binario.
+      \pre El parámetro implícito está vacío. En in se encuentra un conjunto escrito con guardar.
+      \post El parámetro implícito contiene los productos leídos.
+  */
+  void cargar(Lector_binario& in);
 };
 
 #endif
\ No newline at end of file
@@ -3,67 +3,290 @@
 */
 
 #include "Cuenca.hh"
+#include "Flota.hh"
+
+#ifndef NO_DIAGRAM
+#include <cstdio>
+#include <algorithm>
+#endif
+
+// Cabecera de los ficheros de estado: marca y versión del formato.
+static const char MAGIA_ESTADO[8] = { 'P', 'R', 'O', '2', 'E', 'S', 'T', '\0' };
+static const int VERSION_ESTADO = 2;
+
+// Comercios de una ronda de comerciar_lote por debajo de los cuales no se
+// reparte una tarea más.
+static const int PARES_POR_TAREA = 64;
+
+thread_local vector<Cuenca::Aviso>* Cuenca::_avisos_hilo = nullptr;
 
 // Constructora
 
 // Pre: cierto.
 // Post: Devuelve una cuenca no inicializada.
 
-Cuenca::Cuenca() {}
-  
+Cuenca::Cuenca() : _excedentes_al_dia(false), _productos_al_dia(false), _totales_al_dia(false), _pool(nullptr), _corte(CORTE_PARALELO) {
+    _objetivo_plan.id_comprar = _objetivo_plan.id_vender = -1;
+    _objetivo_plan.num_comprar = _objetivo_plan.num_vender = 0;
+    _recuento.aciertos = _recuento.fallos = 0;
+}
+
+// Configuración
+
+// Pre: pool es nulo o sigue existiendo mientras se use la cuenca; corte >= 1.
+// Post: Las operaciones paralelizables se reparten en pool; un subárbol de
+// menos de corte nodos se procesa en un solo hilo.
+
+void Cuenca::usar_hilos(Pool_hilos* pool, int corte) {
+    _pool = pool;
+    _corte = corte;
+}
+
+// Pre: cierto.
+// Post: Devuelve el identificador de la ciudad de nombre t; si no existía,
+// se ha añadido una ciudad vacía con ese nombre.
+
+int Cuenca::anadir_ciudad(const Token& t) {
+    int id = _nombres.anadir(t);
+    if (id == int(_ciudades.size())) {
+        _ciudades.push_back(Ciudad());
+        _ciudades.back().observar(this, id);
+    }
+    return id;
+}
+
+// Pre: cierto.
+// Post: Los índices de la cuenca reflejan el nuevo estado del producto. Si el
+// hilo está haciendo un tramo de redistribuir, el aviso se guarda y se atiende
+// al acabar.
+
+void Cuenca::producto_cambiado(int ciudad, int id_producto, bool presente, int tiene, int necesita) {
+    if (_avisos_hilo != nullptr) {
+        Aviso a = { ciudad, id_producto, presente, tiene, necesita };
+        _avisos_hilo->push_back(a);
+        return;
+    }
+    if (_excedentes_al_dia) _indice.actualizar(ciudad, id_producto, presente, tiene, necesita);
+    if (_productos_al_dia) _productos.actualizar(ciudad, id_producto, presente, tiene, necesita);
+    marcar_sucio(ciudad);
+}
+
+// Pre: cierto.
+// Post: Si _totales está al día, sus nodos de la ciudad tienen los nuevos
+// totales. Si el hilo está guardando los avisos, se guarda y se atiende al
+// acabar.
+
+void Cuenca::totales_cambiados(int ciudad, int peso, int volumen) {
+    if (not _totales_al_dia) return;
+    if (_avisos_hilo != nullptr) {
+        Aviso a = { ciudad, -1, true, peso, volumen };
+        _avisos_hilo->push_back(a);
+        return;
+    }
+    const vector<int>& nodos = _indice.nodos(ciudad);
+    for (int k = 0; k < int(nodos.size()); ++k) _totales.asignar(nodos[k], peso, volumen);
+}
+
+// Pre: cierto.
+// Post: Se ha atendido a como si llegara ahora de su ciudad.
+
+void Cuenca::atender(const Aviso& a) {
+    if (a.id_producto < 0) totales_cambiados(a.ciudad, a.tiene, a.necesita);
+    else producto_cambiado(a.ciudad, a.id_producto, a.presente, a.tiene, a.necesita);
+}
+
+// Pre: cierto.
+// Post: Todas las ciudades avisan a la cuenca de sus cambios, los índices
+// reflejan el estado de todos los inventarios y no se reutiliza ningún
+// resultado de la planificación.
+
+void Cuenca::reconstruir_indices() {
+    _indice.reiniciar(_rio, _ciudades.size());
+    _productos.reiniciar();
+    _excedentes_al_dia = false;
+    _productos_al_dia = false;
+    _totales_al_dia = false;
+    reiniciar_plan();
+    for (int i = 0; i < int(_ciudades.size()); ++i) {
+        _ciudades[i].observar(this, i);
+        _ciudades[i].avisar_inventario();
+    }
+}
+
+// Pre: cierto.
+// Post: _plan y _sucio tienen un elemento por nodo del río y ningún
+// resultado se puede reutilizar.
+
+void Cuenca::reiniciar_plan() {
+    // Nadie llega a un nodo con -1 unidades compradas: ningún resultado coincide.
+    Paso p;
+    p.compradas = p.vendidas = -1;
+    p.unidades_c = p.unidades_v = p.total_c = p.total_v = p.longitud = 0;
+    p.siguiente = -1;
+    _plan.assign(_rio.tamano(), p);
+    _sucio.assign(_rio.tamano(), 0);
+}
+
+// Pre: cierto.
+// Post: Los nodos de la ciudad y sus antecesores están marcados en _sucio.
+
+void Cuenca::marcar_sucio(int ciudad) {
+    // Si un nodo ya está marcado, sus antecesores también: se puede parar ahí.
+    const vector<int>& nodos = _indice.nodos(ciudad);
+    for (int k = 0; k < int(nodos.size()); ++k) {
+        int i = nodos[k];
+        while (i >= 0 and not _sucio[i]) {
+            _sucio[i] = 1;
+            i = _rio.padre(i);
+        }
+    }
+}
+
 // Modificadoras
 
-// Pre: En el canal estándar de entrada se encuentra un entero no negativo, seguido
+// Pre: En el lector in se encuentra un entero no negativo, seguido
 // de una lista de productos no repetidos con el formato correcto, una estructura árborea 
 // correcta de strings e ID's de comprar y vender válidas, num_comprar y vender > 0.
 // Post: Se hace la lectura de la cuenca, de los productos y del barco.
 
-void Cuenca::lectura_inicial(Cjt_productos& cp, Barco &b) {
+void Cuenca::lectura_inicial(Cjt_productos& cp, Barco &b, Lector& in) {
     // Número de productos diferentes y añadirlos
-    int num_productos;
-    cin >> num_productos;
-    cp.agregar_productos(num_productos);
+    int num_productos = in.leer_entero();
+    cp.agregar_productos(num_productos, in);
 
     // Estructura de la cuenca
-    leer_rio();
+    leer_rio(in);
 
     // Datos barco
-    int id_producto_comprar, num_comprar, id_producto_vender, num_vender;
-    cin >> id_producto_comprar >> num_comprar >> id_producto_vender >> num_vender;
+    int id_producto_comprar = in.leer_entero();
+    int num_comprar = in.leer_entero();
+    int id_producto_vender = in.leer_entero();
+    int num_vender = in.leer_entero();
     b = Barco(id_producto_comprar, num_comprar, id_producto_vender, num_vender);
 }
 
-// Pre: El árbol t contiene nombres de ciudades correctos.
-// Post: La ciudad en el nodo actual ha comerciado con la ciudad en su subárbol izquierdo, si existe.
-// Después de procesar el subárbol izquierdo, la ciudad en el nodo actual ha comerciado con la ciudad en su subárbol derecho, si existe.
-// La función se llama recursivamente para los subárboles izquierdo y derecho, siguiendo un recorrido en preorden.
+// Pre: cp es un conjunto de productos válido, inicializado y consistente con los productos en las ciudades.
+// Post: La ciudad de la desembocaduraha comerciado con su ciudad río arriba a la derecha y
+// luego con la ciudad río arriba a la izquierda, sucesivamente.
 
-void Cuenca::redistribuir_rec(BinTree<string>& t, const Cjt_productos& cp) {
-    if (t.empty()) return; // Caso base, árbol vacío.
+void Cuenca::redistribuir(const Cjt_productos& cp) {
+    // En el recorrido recursivo cada ciudad comercia con su hijo izquierdo justo
+    // antes de bajar por él, y con el derecho justo antes de bajar por el
+    // derecho: es decir, cada nodo que no es la desembocadura comercia con su
+    // padre en el orden del preorden, que es el de los vectores del río.
+    if (_pool == nullptr or _rio.tamano() < _corte) {
+        for (int i = 1; i < _rio.tamano(); ++i) {
+            _ciudades[_rio.ciudad(_rio.padre(i))].comerciar(_ciudades[_rio.ciudad(i)], cp);
+        }
+        return;
+    }
 
-    // Caso recursivo:
-    BinTree<string> left = t.left();
-    BinTree<string> right = t.right();
-    string id1 = t.value();
-    // Empezamos por la izquierda.
-    if (not t.left().empty()) { 
-        string id2 = left.value();
-        _lista_ciudades[id1].comerciar(_lista_ciudades[id2], cp);
+    Tramos tr;
+    preparar_tramos(tr);
+    // Se buscan todos los tramos libres antes de lanzar ninguno: una vez
+    // lanzados, los contadores de los demás empiezan a bajar.
+    vector<int> libres;
+    for (int t = 0; t + 1 < int(tr.inicio.size()); ++t) {
+        if (tr.pendientes[t] == 0) libres.push_back(t);
     }
-    redistribuir_rec(left, cp);
-    if (not t.right().empty()) {
-        string id2 = right.value();
-        _lista_ciudades[id1].comerciar(_lista_ciudades[id2], cp);
+    Pool_hilos::Grupo g;
+    for (int k = 0; k < int(libres.size()); ++k) {
+        int t = libres[k];
+        _pool->lanzar(g, [this, t, &tr, &cp, &g] { ejecutar_tramo(t, tr, cp, g); });
+    }
+    _pool->esperar(g);
+
+    // Los índices no admiten hilos: cada tramo ha guardado sus avisos y ahora
+    // se atienden por orden de tramo, que es el orden en que llegarían con un
+    // solo hilo.
+    for (int t = 0; t < int(tr.avisos.size()); ++t) {
+        for (int k = 0; k < int(tr.avisos[t].size()); ++k) {
+            atender(tr.avisos[t][k]);
+        }
     }
-    redistribuir_rec(right, cp);
 }
 
-// Pre: cp es un conjunto de productos válido, inicializado y consistente con los productos en las ciudades.
-// Post: La ciudad de la desembocaduraha comerciado con su ciudad río arriba a la derecha y
-// luego con la ciudad río arriba a la izquierda, sucesivamente.
+// Pre: cierto.
+// Post: Los comercios (padre, nodo) de los nodos que no son la desembocadura
+// están repartidos en tramos de nodos consecutivos en preorden, con sus
+// sucesores y su número de predecesores.
 
-void Cuenca::redistribuir(const Cjt_productos& cp) {
-    redistribuir_rec(_id_ciudades, cp); // Llamamos a la función auxiliar.
+void Cuenca::preparar_tramos(Tramos& tr) const {
+    int n = _rio.tamano();
+    tr.inicio.clear();
+    int k = 1;
+    while (k < n) {
+        tr.inicio.push_back(k);
+        k += _rio.tam(k) < _corte ? _rio.tam(k) : 1;
+    }
+    tr.inicio.push_back(n);
+    int num_tramos = int(tr.inicio.size()) - 1;
+
+    // Los predecesores de un tramo son, para cada ciudad que toca, el último
+    // tramo anterior que la ha tocado. Así cada ciudad sigue recibiendo los
+    // comercios en el orden del preorden, aunque aparezca en varios nodos.
+    vector<int> ultimo(_ciudades.size(), -1);
+    vector<int> origen, destino; // Aristas predecesor -> sucesor.
+    vector<int> previos;
+    for (int t = 0; t < num_tramos; ++t) {
+        previos.clear();
+        for (int i = tr.inicio[t]; i < tr.inicio[t + 1]; ++i) {
+            int ciudades[2] = { _rio.ciudad(_rio.padre(i)), _rio.ciudad(i) };
+            for (int j = 0; j < 2; ++j) {
+                int& u = ultimo[ciudades[j]];
+                if (u >= 0 and u != t) previos.push_back(u);
+                u = t;
+            }
+        }
+        sort(previos.begin(), previos.end());
+        previos.erase(unique(previos.begin(), previos.end()), previos.end());
+        for (int j = 0; j < int(previos.size()); ++j) {
+            origen.push_back(previos[j]);
+            destino.push_back(t);
+        }
+    }
+
+    tr.primer.assign(num_tramos + 1, 0);
+    for (int e = 0; e < int(origen.size()); ++e) ++tr.primer[origen[e] + 1];
+    for (int t = 0; t < num_tramos; ++t) tr.primer[t + 1] += tr.primer[t];
+    tr.sucesores.assign(origen.size(), 0);
+    vector<int> lleno(tr.primer.begin(), tr.primer.end() - 1);
+    vector<atomic<int> > pendientes(num_tramos);
+    for (int t = 0; t < num_tramos; ++t) pendientes[t] = 0;
+    for (int e = 0; e < int(origen.size()); ++e) {
+        tr.sucesores[lleno[origen[e]]++] = destino[e];
+        ++pendientes[destino[e]];
+    }
+    tr.pendientes.swap(pendientes);
+    tr.avisos.assign(num_tramos, vector<Aviso>());
+}
+
+// Pre: Los predecesores del tramo t han acabado; _pool no es nulo.
+// Post: Se han hecho los comercios del tramo t y sus avisos están en
+// tr.avisos[t]. Los sucesores que han quedado libres se han ejecutado también,
+// uno en este hilo y el resto lanzados en g.
+
+void Cuenca::ejecutar_tramo(int t, Tramos& tr, const Cjt_productos& cp, Pool_hilos::Grupo& g) {
+    // Si al acabar se libera un solo sucesor, se sigue con él aquí mismo: en
+    // una cadena de tramos no se paga una tarea por tramo.
+    while (t >= 0) {
+        _avisos_hilo = &tr.avisos[t];
+        for (int i = tr.inicio[t]; i < tr.inicio[t + 1]; ++i) {
+            _ciudades[_rio.ciudad(_rio.padre(i))].comerciar(_ciudades[_rio.ciudad(i)], cp);
+        }
+        _avisos_hilo = nullptr;
+        int seguir = -1;
+        for (int e = tr.primer[t]; e < tr.primer[t + 1]; ++e) {
+            int s = tr.sucesores[e];
+            if (--tr.pendientes[s] > 0) continue;
+            if (seguir < 0) {
+                seguir = s;
+            } else {
+                _pool->lanzar(g, [this, s, &tr, &cp, &g] { ejecutar_tramo(s, tr, cp, g); });
+            }
+        }
+        t = seguir;
+    }
 }
 
 // Pre: cierto.
@@ -72,103 +295,400 @@ void Cuenca::redistribuir(const Cjt_productos& cp) {
 // el total de unidades compradas y vendidas del barco.
 
 void Cuenca::hacer_viaje(Barco& b, const Cjt_productos& cp) {
-    list<ElementoCamino> ruta;
-    pair<int,int> res = encontrar_camino(_id_ciudades, b, 0, 0, ruta);
-    int total = res.first + res.second; // Total de productos comprados y vendidos.
-    cout << total << endl;
+    Viaje v;
+    planificar(b, v);
+    int total = v.compradas + v.vendidas; // Total de productos comprados y vendidos.
+    salida << total << '\n';
         
     if(total != 0){ // Si no se ha comerciado.
-        hacer_camino(ruta, cp, b);
-        b.agregar_ultima_ciudad((ruta.back()).id_ciudad);
+        hacer_camino(v.ruta, cp, b);
+        b.agregar_ultima_ciudad(_nombres.nombre(v.ruta.back().ciudad));
+    }
+}
+
+// Pre: Los barcos están inicializados.
+// Post: Igual que hacer_viaje() con cada barco, en orden.
+
+void Cuenca::hacer_viajes(const vector<Barco*>& barcos, const Cjt_productos& cp) {
+    preparar_excedentes();
+    int k = barcos.size();
+    vector<Objetivo> objetivos(k);
+    for (int j = 0; j < k; ++j) objetivos[j] = objetivo(*barcos[j]);
+    vector<Viaje> viajes;
+    evaluar_viajes(objetivos, viajes);
+
+    // Un viaje solo depende de las unidades de sus dos productos y solo cambia
+    // esas. Si un viaje anterior ya ha tocado alguno de ellos, la ruta se
+    // vuelve a planificar con el estado actual: así quien va antes se queda el
+    // excedente y el resultado es el mismo que uno tras otro.
+    vector<int> tocados;
+    vector<Paso> paso;
+    for (int j = 0; j < k; ++j) {
+        const Objetivo& o = objetivos[j];
+        if (find(tocados.begin(), tocados.end(), o.id_comprar) != tocados.end() or
+            find(tocados.begin(), tocados.end(), o.id_vender) != tocados.end()) {
+            evaluar_viaje(o, paso, viajes[j]);
+        }
+        const Viaje& v = viajes[j];
+        int total = v.compradas + v.vendidas;
+        salida << total << '\n';
+        if (total != 0) {
+            hacer_camino(v.ruta, cp, *barcos[j]);
+            barcos[j]->agregar_ultima_ciudad(_nombres.nombre(v.ruta.back().ciudad));
+            tocados.push_back(o.id_comprar);
+            tocados.push_back(o.id_vender);
+        }
     }
 }
 
 // Pre: cierto.
 // Post: Hace las compras y ventas pasando por la ruta y modificando las ciudades.
 
-void Cuenca::hacer_camino(const list<ElementoCamino>& ruta, const Cjt_productos& cp, Barco& b) {
-    for (auto it = ruta.begin(); it != ruta.end(); ++it) {
-        auto it2 = _lista_ciudades.find((*it).id_ciudad);
-        it2->second.vender_prod(b.consultar_id_prod_comprar(), (*it).unidades_c, cp);
-        it2->second.comprar_prod(b.consultar_id_prod_vender(), (*it).unidades_v, cp);
+void Cuenca::hacer_camino(const vector<ElementoCamino>& ruta, const Cjt_productos& cp, Barco& b) {
+    for (int k = 0; k < int(ruta.size()); ++k) {
+        Ciudad& c = _ciudades[ruta[k].ciudad];
+        c.vender_prod(b.consultar_id_prod_comprar(), ruta[k].unidades_c, cp);
+        c.comprar_prod(b.consultar_id_prod_vender(), ruta[k].unidades_v, cp);
     }
 }
 
-// Pre: cierto.
-// Post: Encuentra el camino que cumple las condiciones pedidas.
+// Pre: El padre de i, si existe, ya está evaluado.
+// Post: paso[i] tiene las unidades compradas y vendidas al llegar a i y las que
+// compra y vende en i, y el resultado de una ruta vacía. Devuelve falso si el
+// barco ya llega completo, y entonces i y su subárbol no aportan nada.
 
-pair<int,int> Cuenca::encontrar_camino(const BinTree<string>& t, Barco& b, int compradas, int vendidas, list<ElementoCamino>& ruta) {
-    if (t.empty() or (compradas == b.consultar_num_comprar() and vendidas == b.consultar_num_vender())) {
-        ruta = list<ElementoCamino>();
-        return make_pair(0,0);
-    } else {
-        auto it = _lista_ciudades.find(t.value());
-        int unidades_c = 0;
-        int unidades_v = 0;
-        if ((*it).second.hay_prod_ciudad(b.consultar_id_prod_comprar())) {
-            int sobra_ciudad_c = (*it).second.consultar_necesitareal_ciudad(b.consultar_id_prod_comprar());
-            if(sobra_ciudad_c > 0){ // Le sobran, podemos comprar.
-                if (sobra_ciudad_c <= b.consultar_num_comprar()-compradas) {
-                    unidades_c = sobra_ciudad_c;
-                } else {
-                    unidades_c = b.consultar_num_comprar()-compradas;
-                }
+bool Cuenca::evaluar_nodo(int i, const Objetivo& o, vector<Paso>& paso) const {
+    Paso& p = paso[i];
+    int padre = _rio.padre(i);
+    p.compradas = padre < 0 ? 0 : paso[padre].compradas + paso[padre].unidades_c;
+    p.vendidas = padre < 0 ? 0 : paso[padre].vendidas + paso[padre].unidades_v;
+    p.unidades_c = 0;
+    p.unidades_v = 0;
+    p.total_c = 0;
+    p.total_v = 0;
+    p.longitud = 0;
+    p.siguiente = -1;
+    if (p.compradas == o.num_comprar and p.vendidas == o.num_vender) return false;
+    // Si en todo el subárbol no hay nada que comprar ni que vender, no hay ruta.
+    int fin = i + _rio.tam(i);
+    if (not _indice.hay_excedente(o.id_comprar, i, fin) and not _indice.hay_deficit(o.id_vender, i, fin)) return false;
+
+    const Ciudad& c = _ciudades[_rio.ciudad(i)];
+    if (c.hay_prod_ciudad(o.id_comprar)) {
+        int sobra_ciudad_c = c.consultar_necesitareal_ciudad(o.id_comprar);
+        if(sobra_ciudad_c > 0){ // Le sobran, podemos comprar.
+            if (sobra_ciudad_c <= o.num_comprar-p.compradas) {
+                p.unidades_c = sobra_ciudad_c;
+            } else {
+                p.unidades_c = o.num_comprar-p.compradas;
             }
         }
-        if ((*it).second.hay_prod_ciudad(b.consultar_id_prod_vender())) {
-            int sobra_ciudad_v = (*it).second.consultar_necesitareal_ciudad(b.consultar_id_prod_vender());
-            if(sobra_ciudad_v < 0){ // Le faltan, podemos vender.
-                sobra_ciudad_v = -sobra_ciudad_v;
-                if (sobra_ciudad_v <= b.consultar_num_vender()-vendidas) {
-                    unidades_v = sobra_ciudad_v;
-                } else {
-                    unidades_v = b.consultar_num_vender()-vendidas;
-                }
+    }
+    if (c.hay_prod_ciudad(o.id_vender)) {
+        int sobra_ciudad_v = c.consultar_necesitareal_ciudad(o.id_vender);
+        if(sobra_ciudad_v < 0){ // Le faltan, podemos vender.
+            sobra_ciudad_v = -sobra_ciudad_v;
+            if (sobra_ciudad_v <= o.num_vender-p.vendidas) {
+                p.unidades_v = sobra_ciudad_v;
+            } else {
+                p.unidades_v = o.num_vender-p.vendidas;
             }
         }
+    }
+    return true;
+}
 
-        list<ElementoCamino> ruta_izq, ruta_der;
-        pair<int,int> res_izq = encontrar_camino(t.left(), b, compradas+unidades_c, vendidas+unidades_v, ruta_izq);
-        int sumaleft = res_izq.first+res_izq.second;
-        pair<int,int> res_der = encontrar_camino(t.right(), b, compradas+unidades_c, vendidas+unidades_v, ruta_der);
-        int sumaright = res_der.first+res_der.second;
-    
-        pair<int,int> ruta_mejor;
-        list<ElementoCamino> ruta_esc;
-        
-        // Escogemos la mejor ruta.
-        if (sumaleft < sumaright) {
-            ruta_mejor = res_der;
-            ruta_esc = ruta_der;
+// Pre: i está evaluado y sus hijos tienen ya su resultado.
+// Post: paso[i] tiene la mejor ruta que empieza en i.
+
+void Cuenca::combinar_nodo(int i, vector<Paso>& paso) const {
+    Paso& p = paso[i];
+    int izq = _rio.izq(i);
+    int der = _rio.der(i);
+    int sumaleft = izq < 0 ? 0 : paso[izq].total_c + paso[izq].total_v;
+    int sumaright = der < 0 ? 0 : paso[der].total_c + paso[der].total_v;
+    int long_izq = izq < 0 ? 0 : paso[izq].longitud;
+    int long_der = der < 0 ? 0 : paso[der].longitud;
+
+    // Escogemos la mejor ruta: más unidades y, a igualdad, la más corta
+    // (la izquierda si miden lo mismo).
+    int mejor;
+    if (sumaleft < sumaright) mejor = der;
+    else if (sumaleft > sumaright) mejor = izq;
+    else mejor = long_izq <= long_der ? izq : der;
+
+    int long_mejor = mejor < 0 ? 0 : paso[mejor].longitud;
+    p.total_c = p.unidades_c + (mejor < 0 ? 0 : paso[mejor].total_c);
+    p.total_v = p.unidades_v + (mejor < 0 ? 0 : paso[mejor].total_v);
+    // El nodo forma parte de la ruta solo cuando sea necesario.
+    if (p.unidades_c > 0 or p.unidades_v > 0 or long_mejor > 0) {
+        p.longitud = long_mejor + 1;
+        p.siguiente = long_mejor > 0 ? mejor : -1;
+    }
+}
+
+// Pre: El padre de i, si existe, ya está evaluado en _plan.
+// Post: Devuelve cierto si el subárbol de i no ha cambiado desde que se
+// calculó su resultado y el barco llega a i con las mismas unidades.
+
+bool Cuenca::reutilizable(int i) const {
+    if (_sucio[i]) return false;
+    int padre = _rio.padre(i);
+    int compradas = padre < 0 ? 0 : _plan[padre].compradas + _plan[padre].unidades_c;
+    int vendidas = padre < 0 ? 0 : _plan[padre].vendidas + _plan[padre].unidades_v;
+    return _plan[i].compradas == compradas and _plan[i].vendidas == vendidas;
+}
+
+// Pre: i no está marcado en _sucio.
+// Post: Ningún nodo del subárbol de i está marcado, y los que lo estaban ya no
+// tienen un resultado reutilizable.
+
+void Cuenca::descartar_subarbol(int i) {
+    // Solo se baja por los nodos marcados: por debajo de uno sin marcar no hay
+    // cambios y los resultados guardados siguen valiendo.
+    vector<int> pila;
+    pila.push_back(i);
+    while (not pila.empty()) {
+        int j = pila.back();
+        pila.pop_back();
+        _sucio[j] = 0;
+        if (j != i) _plan[j].compradas = -1;
+        int izq = _rio.izq(j);
+        int der = _rio.der(j);
+        if (izq >= 0 and _sucio[izq]) pila.push_back(izq);
+        if (der >= 0 and _sucio[der]) pila.push_back(der);
+    }
+}
+
+// Pre: El padre de i, si existe, ya está evaluado en _plan.
+// Post: Devuelve cierto si i se ha evaluado y hay que seguir por sus hijos. Si
+// no, el resultado de i y de su subárbol ya está en _plan, reutilizado o vacío.
+// Se ha contado en r si se ha reutilizado o recalculado.
+
+bool Cuenca::visitar_nodo(int i, const Objetivo& o, Recuento& r) {
+    if (reutilizable(i)) {
+        ++r.aciertos;
+        return false;
+    }
+    ++r.fallos;
+    _sucio[i] = 0;
+    if (evaluar_nodo(i, o, _plan)) return true;
+    // El subárbol no aporta nada y no se recorre: lo que hubiera cambiado en él
+    // deja de estar marcado, así que sus resultados se invalidan.
+    descartar_subarbol(i);
+    return false;
+}
+
+// Pre: El padre de raiz, si existe, ya está evaluado en _plan.
+// Post: Todos los nodos del subárbol de raiz que aportan algo tienen su mejor
+// ruta en _plan; en r se han sumado las cuentas.
+
+void Cuenca::planificar_subarbol(int raiz, const Objetivo& o, Recuento& r) {
+    // Primera fase, de arriba abajo en preorden: cada nodo recibe las unidades
+    // ya compradas y vendidas en su camino desde la desembocadura y decide las
+    // que compraría y vendería él. Si el barco ya va completo, o el subárbol
+    // no ha cambiado y se llega a él igual que la última vez, se salta entero.
+    vector<int> evaluados;
+    int fin = raiz + _rio.tam(raiz);
+    int i = raiz;
+    while (i < fin) {
+        if (visitar_nodo(i, o, r)) {
+            evaluados.push_back(i);
+            ++i;
+        } else {
+            i += _rio.tam(i);
         }
-        else if(sumaleft > sumaright){
-            ruta_mejor = res_izq;
-            ruta_esc = ruta_izq;
+    }
+    // Segunda fase, de abajo arriba: los hijos están después que su padre en el
+    // preorden, así que ya tienen su resultado cuando se combina el padre.
+    for (int k = int(evaluados.size()) - 1; k >= 0; --k) combinar_nodo(evaluados[k], _plan);
+}
+
+// Pre: El padre de raiz, si existe, ya está evaluado en _plan; _pool no es nulo.
+// Post: Igual que planificar_subarbol, repartiendo el trabajo entre los hilos.
+
+void Cuenca::planificar_paralelo(int raiz, const Objetivo& o, Recuento& r) {
+    // Se baja sin recursión por el hijo con el subárbol más grande. El otro
+    // recibe el mismo estado y escribe en una zona disjunta de _plan y _sucio,
+    // así que si es grande se lanza como tarea y si no se planifica aquí mismo.
+    vector<int> camino; // Nodos evaluados del camino, de arriba abajo.
+    deque<Recuento> recuentos; // Cuentas de cada tarea lanzada.
+    Pool_hilos::Grupo g;
+    int i = raiz;
+    while (i >= 0) {
+        if (_rio.tam(i) < _corte) {
+            planificar_subarbol(i, o, r);
+            break;
         }
-        else{
-            if(ruta_izq.size() <= ruta_der.size()){
-                ruta_mejor = res_izq;
-                ruta_esc = ruta_izq;
-            }   
-            else{
-                ruta_mejor = res_der;
-                ruta_esc = ruta_der;
+        if (not visitar_nodo(i, o, r)) break;
+        camino.push_back(i);
+
+        int grande = _rio.izq(i);
+        int pequeno = _rio.der(i);
+        if (pequeno >= 0 and (grande < 0 or _rio.tam(pequeno) > _rio.tam(grande))) swap(grande, pequeno);
+        if (pequeno >= 0) {
+            if (_rio.tam(pequeno) >= _corte) {
+                recuentos.push_back(Recuento());
+                Recuento& rt = recuentos.back();
+                rt.aciertos = rt.fallos = 0;
+                _pool->lanzar(g, [this, pequeno, &o, &rt] { planificar_paralelo(pequeno, o, rt); });
+            } else {
+                planificar_subarbol(pequeno, o, r);
             }
         }
+        i = grande;
+    }
+    _pool->esperar(g);
+    for (int k = 0; k < int(recuentos.size()); ++k) {
+        r.aciertos += recuentos[k].aciertos;
+        r.fallos += recuentos[k].fallos;
+    }
+    for (int k = int(camino.size()) - 1; k >= 0; --k) combinar_nodo(camino[k], _plan);
+}
+
+// Pre: cierto.
+// Post: Devuelve lo que el barco b quiere comprar y vender.
+
+Cuenca::Objetivo Cuenca::objetivo(const Barco& b) {
+    Objetivo o;
+    o.id_comprar = b.consultar_id_prod_comprar();
+    o.num_comprar = b.consultar_num_comprar();
+    o.id_vender = b.consultar_id_prod_vender();
+    o.num_vender = b.consultar_num_vender();
+    return o;
+}
+
+// Pre: cierto.
+// Post: En v están la ruta que seguiría el barco b y las unidades que
+// compraría y vendería en ella. No se modifica ninguna ciudad.
+
+void Cuenca::planificar(const Barco& b, Viaje& v) {
+    preparar_excedentes();
+    Objetivo o = objetivo(b);
+
+    // Con otro objetivo no se puede aprovechar ningún resultado.
+    if (o.id_comprar != _objetivo_plan.id_comprar or o.num_comprar != _objetivo_plan.num_comprar or
+        o.id_vender != _objetivo_plan.id_vender or o.num_vender != _objetivo_plan.num_vender) {
+        reiniciar_plan();
+        _objetivo_plan = o;
+    }
+
+    if (_rio.tamano() > 0) {
+        Recuento r;
+        r.aciertos = r.fallos = 0;
+        if (_pool != nullptr) planificar_paralelo(0, o, r);
+        else planificar_subarbol(0, o, r);
+        _recuento.aciertos += r.aciertos;
+        _recuento.fallos += r.fallos;
+    }
+
+    reconstruir(_plan, v);
+}
+
+// Pre: Los nodos de la mejor ruta desde la desembocadura tienen su resultado en paso.
+// Post: En v están esa ruta y sus unidades compradas y vendidas.
+
+void Cuenca::reconstruir(const vector<Paso>& paso, Viaje& v) const {
+    // Se baja una sola vez desde la desembocadura siguiendo las elecciones.
+    int n = _rio.tamano();
+    v.compradas = n > 0 ? paso[0].total_c : 0;
+    v.vendidas = n > 0 ? paso[0].total_v : 0;
+    v.ruta.clear();
+    int i = (n > 0 and paso[0].longitud > 0) ? 0 : -1;
+    if (i >= 0) v.ruta.reserve(paso[0].longitud);
+    while (i >= 0) {
+        ElementoCamino ec;
+        ec.ciudad = _rio.ciudad(i);
+        ec.unidades_c = paso[i].unidades_c;
+        ec.unidades_v = paso[i].unidades_v;
+        v.ruta.push_back(ec);
+        i = paso[i].siguiente;
+    }
+}
+
+// Pre: cierto.
+// Post: En v está lo mismo que dejaría planificar() para el objetivo o, sin
+// usar ni modificar los resultados guardados; paso queda con resultados
+// intermedios.
+
+void Cuenca::evaluar_viaje(const Objetivo& o, vector<Paso>& paso, Viaje& v) const {
+    int n = _rio.tamano();
+    paso.resize(n);
+    // Las mismas dos fases que planificar_subarbol, sin resultados que reutilizar.
+    vector<int> evaluados;
+    int i = 0;
+    while (i < n) {
+        if (evaluar_nodo(i, o, paso)) {
+            evaluados.push_back(i);
+            ++i;
+        } else {
+            i += _rio.tam(i);
+        }
+    }
+    for (int k = int(evaluados.size()) - 1; k >= 0; --k) combinar_nodo(evaluados[k], paso);
+    reconstruir(paso, v);
+}
+
+// Pre: cierto.
+// Post: viajes[j] es lo que dejaría planificar() para objetivos[j].
 
-        // Hacer push cuando solo cuando sea necesario.
-        if (unidades_c > 0 or unidades_v > 0 or !ruta_esc.empty()) {
-            ElementoCamino ec;
-            ec.id_ciudad = t.value();
-            ec.unidades_c = unidades_c;
-            ec.unidades_v = unidades_v;
-            ruta_esc.push_front(ec);
+void Cuenca::evaluar_viajes(const vector<Objetivo>& objetivos, vector<Viaje>& viajes) const {
+    int k = objetivos.size();
+    viajes.resize(k);
+    // Los viajes solo leen las ciudades, el río y el índice, así que se
+    // reparten entre los hilos; cada tarea tiene su propio vector de pasos.
+    int tareas = _pool == nullptr ? 1 : max(1, min(k, _pool->num_hilos()));
+    auto evaluar_tramo = [this, k, tareas, &objetivos, &viajes](int t) {
+        vector<Paso> paso;
+        for (int j = int((long long)k * t / tareas); j < int((long long)k * (t + 1) / tareas); ++j) {
+            evaluar_viaje(objetivos[j], paso, viajes[j]);
         }
-        // Asignamos la ruta correcta.
-        ruta = ruta_esc;
+    };
+    if (tareas == 1) {
+        evaluar_tramo(0);
+    } else {
+        Pool_hilos::Grupo g;
+        for (int t = 0; t < tareas; ++t) _pool->lanzar(g, [t, &evaluar_tramo] { evaluar_tramo(t); });
+        _pool->esperar(g);
+    }
+}
+
+// Pre: cierto.
+// Post: Para cada barco, en orden, escribe el error de modificar_barco si sus
+// productos no son válidos y, si no, lo que compraría y vendería en un viaje y
+// la primera y la última ciudad de la ruta. No se modifica ninguna ciudad.
 
-        // Actualizamos los productos que hemos comerciado.
-        return make_pair(ruta_mejor.first+unidades_c, ruta_mejor.second+unidades_v);
+void Cuenca::simular_viajes(const vector<Barco>& barcos, const Cjt_productos& cp) {
+    preparar_excedentes();
+    int k = barcos.size();
+    vector<char> valido(k);
+    vector<Objetivo> objetivos;
+    for (int j = 0; j < k; ++j) {
+        int id_c = barcos[j].consultar_id_prod_comprar();
+        int id_v = barcos[j].consultar_id_prod_vender();
+        valido[j] = cp.hay_prod(id_c) and cp.hay_prod(id_v) and id_c != id_v;
+        if (valido[j]) objetivos.push_back(objetivo(barcos[j]));
+    }
+    vector<Viaje> viajes;
+    evaluar_viajes(objetivos, viajes);
+
+    int siguiente = 0; // Siguiente viaje evaluado.
+    for (int j = 0; j < k; ++j) {
+        if (not valido[j]) {
+            if (barcos[j].consultar_id_prod_comprar() == barcos[j].consultar_id_prod_vender() and
+                cp.hay_prod(barcos[j].consultar_id_prod_comprar())) {
+                salida << "error: no se puede comprar y vender el mismo producto\n";
+            } else {
+                salida << "error: no existe el producto\n";
+            }
+            continue;
+        }
+        const Viaje& v = viajes[siguiente++];
+        salida << v.compradas << ' ' << v.vendidas;
+        if (not v.ruta.empty()) {
+            salida << ' ' << _nombres.nombre(v.ruta.front().ciudad) << ' ' << _nombres.nombre(v.ruta.back().ciudad);
+        }
+        salida << '\n';
     }
 }
 
@@ -178,58 +698,145 @@ pair<int,int> Cuenca::encontrar_camino(const BinTree<string>& t, Barco& b, int c
 // ciudad y que necesite la otra. Los inventarios de ambas ciudades se han actualizado.
 // Los atributos de peso y volumen total de ambas ciudades se han ajustado adecuadamente.
 
-void Cuenca::comerciar(string id_ciudad1, string id_ciudad2, const Cjt_productos& cp) {
-    if (not hay_ciudad(id_ciudad1) or not hay_ciudad(id_ciudad2)) {
-        cout << "error: no existe la ciudad" << endl;
-    } else if (id_ciudad1 == id_ciudad2) {
-        cout << "error: ciudad repetida" << endl;
+void Cuenca::comerciar(const string& id_ciudad1, const string& id_ciudad2, const Cjt_productos& cp) {
+    int c1 = _nombres.buscar(id_ciudad1);
+    int c2 = _nombres.buscar(id_ciudad2);
+    if (c1 < 0 or c2 < 0) {
+        salida << "error: no existe la ciudad\n";
+    } else if (c1 == c2) {
+        salida << "error: ciudad repetida\n";
     } else {
-        _lista_ciudades[id_ciudad1].comerciar(_lista_ciudades[id_ciudad2], cp);
+        _ciudades[c1].comerciar(_ciudades[c2], cp);
+    }
+}
+
+// Pre: cp es un conjunto de productos válido, inicializado y consistente con
+// los productos en las ciudades.
+// Post: Igual que comerciar() con cada pareja de pares, en orden.
+
+void Cuenca::comerciar_lote(const vector<pair<string, string> >& pares, const Cjt_productos& cp) {
+    // Los errores solo dependen de los nombres y los comercios válidos no
+    // escriben nada, así que se escriben todos primero, en orden.
+    vector<pair<int, int> > comercios;
+    comercios.reserve(pares.size());
+    for (int k = 0; k < int(pares.size()); ++k) {
+        int c1 = _nombres.buscar(pares[k].first);
+        int c2 = _nombres.buscar(pares[k].second);
+        if (c1 < 0 or c2 < 0) salida << "error: no existe la ciudad\n";
+        else if (c1 == c2) salida << "error: ciudad repetida\n";
+        else comercios.push_back(make_pair(c1, c2));
+    }
+    int m = comercios.size();
+    if (_pool == nullptr or m < 2 * PARES_POR_TAREA) {
+        for (int k = 0; k < m; ++k) {
+            _ciudades[comercios[k].first].comerciar(_ciudades[comercios[k].second], cp);
+        }
+        return;
+    }
+
+    // Cada comercio va en la ronda siguiente a la última en la que salen sus
+    // ciudades: en una ronda no se repite ninguna y cada ciudad comercia en el
+    // mismo orden que uno tras otro.
+    vector<int> ultima(_ciudades.size(), -1);
+    vector<int> ronda(m);
+    int num_rondas = 0;
+    for (int k = 0; k < m; ++k) {
+        int& u1 = ultima[comercios[k].first];
+        int& u2 = ultima[comercios[k].second];
+        ronda[k] = max(u1, u2) + 1;
+        u1 = u2 = ronda[k];
+        num_rondas = max(num_rondas, ronda[k] + 1);
+    }
+    // La ronda r son los comercios orden[inicio[r]] .. orden[inicio[r+1]-1].
+    vector<int> inicio(num_rondas + 1, 0);
+    for (int k = 0; k < m; ++k) ++inicio[ronda[k] + 1];
+    for (int r = 0; r < num_rondas; ++r) inicio[r + 1] += inicio[r];
+    vector<int> orden(m);
+    vector<int> sig(inicio.begin(), inicio.end() - 1);
+    for (int k = 0; k < m; ++k) orden[sig[ronda[k]]++] = k;
+
+    int max_tareas = 4 * _pool->num_hilos();
+    vector<vector<Aviso> > avisos(max_tareas);
+    for (int r = 0; r < num_rondas; ++r) {
+        int n = inicio[r + 1] - inicio[r];
+        int tareas = min(max_tareas, n / PARES_POR_TAREA);
+        if (tareas <= 1) {
+            for (int k = inicio[r]; k < inicio[r + 1]; ++k) {
+                const pair<int, int>& c = comercios[orden[k]];
+                _ciudades[c.first].comerciar(_ciudades[c.second], cp);
+            }
+            continue;
+        }
+        Pool_hilos::Grupo g;
+        for (int t = 0; t < tareas; ++t) {
+            int desde = inicio[r] + int((long long)n * t / tareas);
+            int hasta = inicio[r] + int((long long)n * (t + 1) / tareas);
+            _pool->lanzar(g, [this, t, desde, hasta, &avisos, &orden, &comercios, &cp] {
+                _avisos_hilo = &avisos[t];
+                for (int k = desde; k < hasta; ++k) {
+                    const pair<int, int>& c = comercios[orden[k]];
+                    _ciudades[c.first].comerciar(_ciudades[c.second], cp);
+                }
+                _avisos_hilo = nullptr;
+            });
+        }
+        _pool->esperar(g);
+        // El índice solo depende del último aviso de cada ciudad y producto, y
+        // en una ronda cada ciudad sale en una sola tarea.
+        for (int t = 0; t < tareas; ++t) {
+            for (int i = 0; i < int(avisos[t].size()); ++i) {
+                atender(avisos[t][i]);
+            }
+            avisos[t].clear();
+        }
     }
 }
 
 // Pre: prod_tiene + prod_necesita > 0
 // Post: Añade el producto al inventario de la ciudad.
 
-void Cuenca::poner_prod(string id_ciudad, int id_producto, int prod_tiene, int prod_necesita, const Cjt_productos& cp) {
+void Cuenca::poner_prod(const string& id_ciudad, int id_producto, int prod_tiene, int prod_necesita, const Cjt_productos& cp) {
+    int c = _nombres.buscar(id_ciudad);
     if (not cp.hay_prod(id_producto)) {
-        cout << "error: no existe el producto" << endl;
-    } else if (not hay_ciudad(id_ciudad)) {
-        cout << "error: no existe la ciudad" << endl;
-    } else if (hay_prod_ciudad(id_ciudad, id_producto)) {
-        cout << "error: la ciudad ya tiene el producto" << endl;
+        salida << "error: no existe el producto\n";
+    } else if (c < 0) {
+        salida << "error: no existe la ciudad\n";
+    } else if (_ciudades[c].hay_prod_ciudad(id_producto)) {
+        salida << "error: la ciudad ya tiene el producto\n";
     } else {
-        _lista_ciudades[id_ciudad].poner_prod(id_producto, prod_tiene, prod_necesita, cp);
+        _ciudades[c].poner_prod(id_producto, prod_tiene, prod_necesita, cp);
     }
 }
 
 // Pre: prod_tiene + prod_necesita > 0
 // Post: Modifica los datos del inventario de la ciudad.
 
-void Cuenca::modificar_prod(string id_ciudad, int id_producto, int prod_tiene, int prod_necesita, const Cjt_productos& cp) {
+void Cuenca::modificar_prod(const string& id_ciudad, int id_producto, int prod_tiene, int prod_necesita, const Cjt_productos& cp) {
+    int c = _nombres.buscar(id_ciudad);
     if (not cp.hay_prod(id_producto)) {
-        cout << "error: no existe el producto" << endl;
-    } else if (not hay_ciudad(id_ciudad)) {
-        cout << "error: no existe la ciudad" << endl;
-    } else if (not hay_prod_ciudad(id_ciudad, id_producto)) {
-        cout << "error: la ciudad no tiene el producto" << endl;
+        salida << "error: no existe el producto\n";
+    } else if (c < 0) {
+        salida << "error: no existe la ciudad\n";
+    } else if (not _ciudades[c].hay_prod_ciudad(id_producto)) {
+        salida << "error: la ciudad no tiene el producto\n";
     } else {
-        _lista_ciudades[id_ciudad].modificar_prod(id_producto, prod_tiene, prod_necesita, cp);
+        _ciudades[c].modificar_prod(id_producto, prod_tiene, prod_necesita, cp);
     }
 }
 
 // Pre: cierto.
 // Post: Quita un producto del inventario.
 
-void Cuenca::quitar_prod(string id_ciudad, int id_producto, const Cjt_productos& cp) {
+void Cuenca::quitar_prod(const string& id_ciudad, int id_producto, const Cjt_productos& cp) {
+    int c = _nombres.buscar(id_ciudad);
     if (!cp.hay_prod(id_producto)) {
-        cout << "error: no existe el producto" << endl;
-    } else if (not hay_ciudad(id_ciudad)) {
-        cout << "error: no existe la ciudad" << endl;
-    } else if (not hay_prod_ciudad(id_ciudad, id_producto)) {
-        cout << "error: la ciudad no tiene el producto" << endl;
+        salida << "error: no existe el producto\n";
+    } else if (c < 0) {
+        salida << "error: no existe la ciudad\n";
+    } else if (not _ciudades[c].hay_prod_ciudad(id_producto)) {
+        salida << "error: la ciudad no tiene el producto\n";
     } else {
-        _lista_ciudades[id_ciudad].quitar_prod(id_producto, cp);
+        _ciudades[c].quitar_prod(id_producto, cp);
     }
 }
   
@@ -238,102 +845,394 @@ void Cuenca::quitar_prod(string id_ciudad, int id_producto, const Cjt_productos&
 // Pre: cierto.
 // Post: Devuelve true si existe la ciudad, false de lo contrario.
 
-bool Cuenca::hay_ciudad(string id_ciudad) const {
-    return _lista_ciudades.find(id_ciudad) != _lista_ciudades.end();
+bool Cuenca::hay_ciudad(const string& id_ciudad) const {
+    return _nombres.buscar(id_ciudad) >= 0;
 }
 
 // Pre: cierto.
 // Post: Escribe true si el producto está en el inventario, falso de lo contrario.
 
-bool Cuenca::hay_prod_ciudad(string id_ciudad, int id_producto) const {
-    return _lista_ciudades.at(id_ciudad).hay_prod_ciudad(id_producto);
+bool Cuenca::hay_prod_ciudad(const string& id_ciudad, int id_producto) const {
+    int c = _nombres.buscar(id_ciudad);
+    return c >= 0 and _ciudades[c].hay_prod_ciudad(id_producto);
 }
 
 // Pre: cierto.
 // Post: Devuelve el producto consultado.
 
-void Cuenca::consultar_prod_ciudad(string id_ciudad, int id_producto, const Cjt_productos& cp) const {
+void Cuenca::consultar_prod_ciudad(const string& id_ciudad, int id_producto, const Cjt_productos& cp) const {
+    int c = _nombres.buscar(id_ciudad);
     if (not cp.hay_prod(id_producto)) {
-        cout << "error: no existe el producto" << endl;
-    } else if (not hay_ciudad(id_ciudad)) {
-        cout << "error: no existe la ciudad" << endl;
-    } else if (not hay_prod_ciudad(id_ciudad, id_producto)) {
-        cout << "error: la ciudad no tiene el producto" << endl;
+        salida << "error: no existe el producto\n";
+    } else if (c < 0) {
+        salida << "error: no existe la ciudad\n";
+    } else if (not _ciudades[c].hay_prod_ciudad(id_producto)) {
+        salida << "error: la ciudad no tiene el producto\n";
     } else {
-        _lista_ciudades.at(id_ciudad).consultar_prod_ciudad(id_producto);
+        _ciudades[c].consultar_prod_ciudad(id_producto);
     }
 }
 
+// Pre: cierto.
+// Post: Devuelve cuántos subárboles se han reutilizado sin recorrerlos en
+// todas las planificaciones de viajes.
+
+long long Cuenca::aciertos_plan() const {
+    return _recuento.aciertos;
+}
+
+// Pre: cierto.
+// Post: Devuelve cuántos nodos se han tenido que volver a calcular en todas
+// las planificaciones de viajes.
+
+long long Cuenca::fallos_plan() const {
+    return _recuento.fallos;
+}
+
 // Escritura
 
 // Pre: cierto.
 // Post: Se ha escrito el inventario, peso y volumen total de la ciudad en el canal estándard
 // de salida.
 
-void Cuenca::escribir_ciudad(string id_ciudad) const {
-    if (hay_ciudad(id_ciudad)) {
-        _lista_ciudades.at(id_ciudad).escribir_ciudad();
+void Cuenca::escribir_ciudad(const string& id_ciudad) const {
+    int c = _nombres.buscar(id_ciudad);
+    if (c >= 0) {
+        _ciudades[c].escribir_ciudad();
     } else {
-        cout << "error: no existe la ciudad" << endl;
+        salida << "error: no existe la ciudad\n";
+    }
+}
+
+// Pre: cierto.
+// Post: Se ha escrito cuánto sobra del producto en total y en cuántas
+// ciudades y, en orden de identificador, cada una con lo que le sobra; o un
+// error si el producto no existe.
+
+void Cuenca::escribir_excedentes(int id_producto, const Cjt_productos& cp) {
+    if (not cp.hay_prod(id_producto)) {
+        salida << "error: no existe el producto\n";
+        return;
+    }
+    preparar_productos();
+    escribir_grupo(id_producto, Indice_productos::EXCEDENTE, _productos.excedente(id_producto));
+}
+
+// Pre: cierto.
+// Post: Igual que escribir_excedentes con las ciudades a las que les falta el
+// producto y lo que les falta.
+
+void Cuenca::escribir_deficits(int id_producto, const Cjt_productos& cp) {
+    if (not cp.hay_prod(id_producto)) {
+        salida << "error: no existe el producto\n";
+        return;
     }
+    preparar_productos();
+    escribir_grupo(id_producto, Indice_productos::DEFICIT, _productos.deficit(id_producto));
+}
+
+// Pre: cierto.
+// Post: _indice refleja los excedentes y déficits de todas las ciudades del
+// río y se mantiene al día con sus avisos.
+
+void Cuenca::preparar_excedentes() {
+    if (_excedentes_al_dia) return;
+    _indice.vaciar();
+    for (int i = 0; i < int(_ciudades.size()); ++i) _ciudades[i].avisar_inventario(_indice);
+    _excedentes_al_dia = true;
+}
+
+// Pre: cierto.
+// Post: _productos refleja los inventarios de todas las ciudades y se mantiene
+// al día con sus avisos.
+
+void Cuenca::preparar_productos() {
+    if (_productos_al_dia) return;
+    _productos.reiniciar();
+    for (int i = 0; i < int(_ciudades.size()); ++i) _ciudades[i].avisar_inventario(_productos);
+    _productos_al_dia = true;
+}
+
+// Pre: cierto.
+// Post: Se ha escrito total y el número de ciudades del grupo g del producto
+// y, en orden de identificador, cada ciudad con lo que le sobra o le falta.
+
+void Cuenca::escribir_grupo(int id_producto, Indice_productos::Grupo g, long long total) const {
+    // El índice no guarda orden: se ordena solo la respuesta.
+    vector<Indice_productos::Tenencia> t = _productos.ciudades(id_producto, g);
+    sort(t.begin(), t.end(), [](const Indice_productos::Tenencia& a, const Indice_productos::Tenencia& b) {
+        return a.ciudad < b.ciudad;
+    });
+    salida << total << ' ' << int(t.size()) << '\n';
+    for (int k = 0; k < int(t.size()); ++k) {
+        int sobra = t[k].tiene - t[k].necesita;
+        salida << _nombres.nombre(t[k].ciudad) << ' ' << (sobra < 0 ? -sobra : sobra) << '\n';
+    }
+}
+
+// Pre: cierto.
+// Post: Se ha escrito la suma de los excedentes y la de los déficits de todos
+// los productos en todas las ciudades.
+
+void Cuenca::escribir_totales() {
+    preparar_productos();
+    salida << _productos.excedente_total() << ' ' << _productos.deficit_total() << '\n';
+}
+
+// Pre: cierto.
+// Post: _totales refleja el peso y el volumen de todas las ciudades del río y
+// se mantiene al día con sus avisos.
+
+void Cuenca::preparar_totales() {
+    if (_totales_al_dia) return;
+    _totales.reiniciar(_rio, _ciudades);
+    _totales_al_dia = true;
+}
+
+// Pre: cierto.
+// Post: Se ha escrito el peso y el volumen total de las ciudades del subárbol
+// del primer nodo en preorden de la ciudad, ella incluida, o un error si no
+// existe o no está en el río.
+
+void Cuenca::escribir_afluente(const string& id_ciudad) {
+    int i = nodo_camino(id_ciudad);
+    if (i < 0) return;
+    preparar_totales();
+    long long peso = 0;
+    long long volumen = 0;
+    _totales.sumar(i, _rio.tam(i), peso, volumen);
+    salida << peso << ' ' << volumen << '\n';
+}
+
+// Pre: cierto.
+// Post: Devuelve el primer nodo en preorden de la ciudad de nombre id_ciudad.
+// Si no existe o no está en el río, se ha escrito el error y devuelve -1.
+
+int Cuenca::nodo_camino(const string& id_ciudad) const {
+    int c = _nombres.buscar(id_ciudad);
+    if (c < 0) {
+        salida << "error: no existe la ciudad\n";
+        return -1;
+    }
+    const vector<int>& nodos = _indice.nodos(c);
+    if (nodos.empty()) {
+        salida << "error: la ciudad no esta en el rio\n";
+        return -1;
+    }
+    return nodos[0];
+}
+
+// Pre: cierto.
+// Post: Se ha escrito el número de tramos de río que separan el primer nodo de
+// cada ciudad, o un error si alguna no existe o no está en el río.
+
+void Cuenca::escribir_distancia(const string& id_ciudad1, const string& id_ciudad2) const {
+    int a = nodo_camino(id_ciudad1);
+    if (a < 0) return;
+    int b = nodo_camino(id_ciudad2);
+    if (b < 0) return;
+    salida << _rio.distancia(a, b) << '\n';
+}
+
+// Pre: cierto.
+// Post: Se ha escrito el número de ciudades del camino por el río entre el
+// primer nodo de cada ciudad y, en orden, cada una de ellas; o un error si
+// alguna no existe o no está en el río.
+
+void Cuenca::escribir_camino(const string& id_ciudad1, const string& id_ciudad2) const {
+    int a = nodo_camino(id_ciudad1);
+    if (a < 0) return;
+    int b = nodo_camino(id_ciudad2);
+    if (b < 0) return;
+    int comun = _rio.antecesor_comun(a, b);
+    salida << _rio.distancia(a, b) + 1 << '\n';
+    // De a baja hasta el antecesor común, incluido.
+    for (int i = a; i != comun; i = _rio.padre(i)) salida << _nombres.nombre(_rio.ciudad(i)) << '\n';
+    salida << _nombres.nombre(_rio.ciudad(comun)) << '\n';
+    // Y sube hasta b: el tramo de b se recorre al revés.
+    int n = _rio.profundidad(b) - _rio.profundidad(comun);
+    vector<int> subida(n);
+    for (int i = b; i != comun; i = _rio.padre(i)) subida[--n] = i;
+    for (int k = 0; k < int(subida.size()); ++k) salida << _nombres.nombre(_rio.ciudad(subida[k])) << '\n';
 }
 
 // Lectura
 
-// Pre: En el canal estándar de entrada se encuentran strings con nombres
+// Pre: En el lector in se encuentran strings con nombres
 // de ciudades y "#" que forman una estructura árborea binaria válida. 
 // Post: Se han leído los nombres de las ciudades indicando la estructura de la cuenca.
 
-void Cuenca::leer_rio() {
-    _lista_ciudades.clear();
-    _id_ciudades = leer_rio_rec(); // Se reinicia correctamente?
+void Cuenca::leer_rio(Lector& in) {
+    _nombres.vaciar();
+    _ciudades.clear();
+    leer_estructura(in);
+    _indice.reiniciar(_rio, _ciudades.size());
+    _productos.reiniciar();
+    _excedentes_al_dia = false;
+    _productos_al_dia = false;
+    _totales_al_dia = false;
+    reiniciar_plan();
 }
 
-// Pre: En el canal estándar de entrada se encuentran strings con nombres
+// Pre: En el lector in se encuentran strings con nombres
 // de ciudades y "#" que forman una estructura árborea binaria válida. 
-// Post: Se ha leído un árbol binario desde el canal estándar de entrada en preorden.
-    // Cada nodo contiene un nombre de ciudad, y los nodos hoja se representan con "#".
-    // Se devuelve un BinTree<string> que representa la estructura leída.
+// Post: Se ha leído un árbol binario desde el lector en preorden, en una
+// sola pasada y sin recursión. Cada nodo contiene un nombre de ciudad, y los
+// árboles vacíos se representan con "#" (o con el final de la entrada).
+// Se internan los nombres y _rio pasa a tener sus identificadores.
 
-BinTree<string> Cuenca::leer_rio_rec() {
-    string id_ciudad;
-    cin >> id_ciudad;
-
-    // Leemos en preorden
-    if (id_ciudad != "#") {
-        Ciudad c;
-        _lista_ciudades[id_ciudad] = c;
-        BinTree<string> left = leer_rio_rec();
-        BinTree<string> right = leer_rio_rec();
-        return BinTree<string>(id_ciudad, left, right);
-    } else {
-        return BinTree<string>();
+void Cuenca::leer_estructura(Lector& in) {
+    _rio.empezar();
+    Token t;
+    while (not _rio.completo()) {
+        if (not in.leer_token(t) or t.es("#")) _rio.vacio();
+        else _rio.nodo(anadir_ciudad(t));
     }
 }
 
-// Pre: En el canal estándar de entrada se encuentran uno o más strings representando
+// Pre: En el lector in se encuentran uno o más strings representando
 // una ID de ciudad y por cada string, un entero no negativo. Posteriormente, se leen
 // tres enteros el número de veces indicado por el anterior entero, todos 
 // estrictamente positivos excepto el segundo que puede ser cero.
 // Post: Se han leído los inventarios de las ciudades.
 
-void Cuenca::leer_inventarios(const Cjt_productos& cp) {
-    string id_ciudad;
-    while (cin >> id_ciudad and id_ciudad != "#") {
-        _lista_ciudades[id_ciudad].leer_inventario(cp);
+void Cuenca::leer_inventarios(const Cjt_productos& cp, Lector& in) {
+    Token t;
+    while (in.leer_token(t) and not t.es("#")) {
+        _ciudades[anadir_ciudad(t)].leer_inventario(cp, in);
     }
 }    
 
-// Pre: En el canal estándar de entrada se encuentran un string representando
+// Pre: En el lector in se encuentran un string representando
 // una ID de ciudad y un entero no negativo. Posteriormente, se leen
 // tres enteros el número de veces indicado por el anterior entero, todos 
 // estrictamente positivos excepto el segundo que puede ser cero.
 // Post: Se ha leído el inventario de la ciudad.
 
-void Cuenca::leer_inventario(string id_ciudad, const Cjt_productos& cp) {
-    if (hay_ciudad(id_ciudad)) {
-            _lista_ciudades[id_ciudad].leer_inventario(cp);
+void Cuenca::leer_inventario(const string& id_ciudad, const Cjt_productos& cp, Lector& in) {
+    int c = _nombres.buscar(id_ciudad);
+    if (c >= 0) {
+            _ciudades[c].leer_inventario(cp, in);
     } else {
-            cout << "error: no existe la ciudad" << endl;
+            salida << "error: no existe la ciudad\n";
+    }
+}
+
+// Estado binario
+
+// Pre: cierto.
+// Post: Se ha escrito _rio en out en preorden: cada nodo con su
+// nombre y cada árbol vacío con longitud -1.
+
+void Cuenca::guardar_estructura(Escritor_binario& out) const {
+    // Pila de nodos por escribir, con -1 para los árboles vacíos.
+    vector<int> pila(1, _rio.tamano() > 0 ? 0 : -1);
+    while (not pila.empty()) {
+        int i = pila.back();
+        pila.pop_back();
+        if (i < 0) {
+            out.entero(-1);
+        } else {
+            out.cadena(_nombres.nombre(_rio.ciudad(i)));
+            pila.push_back(_rio.der(i));
+            pila.push_back(_rio.izq(i));
+        }
+    }
+}
+
+// Pre: En in se encuentra un árbol escrito con guardar_estructura.
+// Post: Se internan los nombres y _rio pasa a ser el árbol leído.
+
+void Cuenca::cargar_estructura(Lector_binario& in) {
+    _rio.empezar();
+    string id_ciudad;
+    while (not _rio.completo()) {
+        int n = in.entero();
+        // Una longitud mayor que lo que queda del fichero deja el lector en
+        // error, y el resto del árbol se completa con vacíos.
+        if (n < 0 or not in.ok() or not in.quedan(n)) {
+            _rio.vacio();
+        } else {
+            id_ciudad.assign(n, ' ');
+            if (n > 0) in.bytes(&id_ciudad[0], n);
+            _rio.nodo(anadir_ciudad(Token{ id_ciudad.data(), n }));
+        }
     }
-}
\ No newline at end of file
+}
+
+// Pre: Barco inicializado.
+// Post: Se ha escrito en el fichero una imagen con versión del conjunto de
+// productos, la estructura de la cuenca, los inventarios de las ciudades, el
+// barco y la flota. Si no se ha podido escribir se escribe un error y el
+// fichero anterior, si existía, se conserva.
+
+void Cuenca::guardar_estado(const string& fichero, const Cjt_productos& cp, const Barco& b, const Flota& f) const {
+    // Se escribe en un temporal y se renombra: o queda la imagen nueva entera o la anterior.
+    string temporal = fichero + ".tmp";
+    Escritor_binario out(temporal);
+    out.bytes(MAGIA_ESTADO, sizeof(MAGIA_ESTADO));
+    out.entero(VERSION_ESTADO);
+
+    cp.guardar(out);
+    guardar_estructura(out);
+    out.entero(_ciudades.size());
+    for (int i = 0; i < int(_ciudades.size()); ++i) {
+        out.cadena(_nombres.nombre(i));
+        _ciudades[i].guardar(out);
+    }
+    b.guardar(out);
+    f.guardar(out);
+    out.bytes(MAGIA_ESTADO, sizeof(MAGIA_ESTADO)); // Marca de final completo.
+
+    if (not out.cerrar() or rename(temporal.c_str(), fichero.c_str()) != 0) {
+        remove(temporal.c_str());
+        salida << "error: no se puede escribir el fichero\n";
+    }
+}
+
+// Pre: in está al principio de la imagen.
+// Post: Si in contiene una imagen válida escrita con guardar_estado, la
+// cuenca, cp, b y f pasan a ser los guardados y se devuelve cierto. Si no, se
+// escribe un error, no se modifica nada y se devuelve falso.
+
+bool Cuenca::cargar_estado(Lector_binario& in, Cjt_productos& cp, Barco& b, Flota& f) {
+    char magia[sizeof(MAGIA_ESTADO)];
+    in.bytes(magia, sizeof(magia));
+    int version = in.entero();
+    if (not in.ok() or memcmp(magia, MAGIA_ESTADO, sizeof(magia)) != 0 or version != VERSION_ESTADO) {
+        salida << "error: el fichero no contiene un estado valido\n";
+        return false;
+    }
+
+    // Se carga todo aparte y solo se sustituye el estado actual si la imagen está completa.
+    Cuenca c;
+    Cjt_productos cp_nuevo;
+    Barco b_nuevo;
+    Flota f_nuevo;
+    cp_nuevo.cargar(in);
+    c.cargar_estructura(in);
+    // Los productos de los inventarios y de los barcos deben existir en el
+    // conjunto cargado: si no, la imagen no es válida aunque esté completa.
+    bool valido = true;
+    int num_ciudades = in.entero();
+    for (int i = 0; i < num_ciudades and in.ok() and valido; ++i) {
+        string id_ciudad = in.cadena();
+        valido = c._ciudades[c.anadir_ciudad(Token{ id_ciudad.data(), int(id_ciudad.size()) })].cargar(in, cp_nuevo);
+    }
+    valido = valido and b_nuevo.cargar(in, cp_nuevo);
+    valido = valido and f_nuevo.cargar(in, cp_nuevo);
+    in.bytes(magia, sizeof(magia));
+
+    if (not valido or not in.ok() or memcmp(magia, MAGIA_ESTADO, sizeof(magia)) != 0) {
+        salida << "error: el fichero no contiene un estado valido\n";
+        return false;
+    }
+    c.usar_hilos(_pool, _corte);
+    c._recuento = _recuento;
+    *this = move(c);
+    reconstruir_indices(); // Las ciudades copiadas avisaban a c.
+    cp = cp_nuevo;
+    b = b_nuevo;
+    f = f_nuevo;
+    return true;
+}
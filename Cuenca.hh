@@ -8,10 +8,14 @@
 #include "Cjt_productos.hh"
 #include "Ciudad.hh"
 #include "Barco.hh"
+#include "Tabla_ciudades.hh"
+#include "Rio.hh"
+#include "Pool_hilos.hh"
+#include "Indice_excedentes.hh"
+#include "Indice_productos.hh"
+#include "Totales_rio.hh"
 
-#ifndef NO_DIAGRAM
-#include "BinTree.hh"
-#endif
+class Flota;
 
 /** @class Cuenca
     @brief Representa una cuenca, con sus respectivas ciudades.
@@ -20,47 +24,348 @@
     con ciudades ubicadas en puntos específicos como las fuentes y las confluencias de los ríos. 
     Proporciona diversas operaciones para gestionar la lectura y escritura de datos de la cuenca, 
     redistribuir productos entre las ciudades, y realizar operaciones comerciales mediante un barco.
+
+    Los nombres de las ciudades se internan al leerlos y dentro de la cuenca cada
+    ciudad se identifica por un entero: su posición en el vector de ciudades. La
+    estructura del río guarda esos identificadores, de modo que los recorridos no
+    buscan ningún nombre; los nombres solo se usan al leer y al escribir.
+
+    La cuenca observa los cambios de sus ciudades para mantener al día un índice
+    de los nodos con excedente o déficit de cada producto, con el que la
+    planificación de un viaje se salta los afluentes que no pueden aportar nada,
+    y para marcar los nodos cuyo resultado de la última planificación ya no vale.
 */
 
-class Cuenca
+class Cuenca : private Ciudad::Observador
 {
 
 private:
   /** @brief Struct para optimizar función hacer_viaje */
   struct ElementoCamino {
-    string id_ciudad;
-    int unidades_c; // Almacena las operaciones que hacemos dentro de encontrar_camino
-    int unidades_v; // para que el código sea más eficiente y no repetir cálculos
+    int ciudad; // Identificador de la ciudad.
+    int unidades_c; // Unidades que el barco le compra.
+    int unidades_v; // Unidades que el barco le vende.
+  };
+  /** @brief Resultado de planificar un viaje. */
+  struct Viaje {
+    int compradas; // Total de unidades compradas.
+    int vendidas; // Total de unidades vendidas.
+    vector<ElementoCamino> ruta; // Ciudades de la ruta, desde la desembocadura.
+  };
+  /** @brief Lo que el barco quiere comprar y vender. */
+  struct Objetivo {
+    int id_comprar, num_comprar; // Producto y unidades a comprar.
+    int id_vender, num_vender; // Producto y unidades a vender.
+  };
+  /** @brief Registro de la planificación de un viaje para un nodo del río. */
+  struct Paso {
+    int compradas, vendidas; // Unidades ya compradas y vendidas al llegar al nodo.
+    int unidades_c, unidades_v; // Unidades que compra y vende en el nodo.
+    int total_c, total_v; // Unidades de la mejor ruta que empieza en el nodo.
+    int longitud; // Número de ciudades de esa ruta (0 si está vacía).
+    int siguiente; // Siguiente nodo de la ruta, o -1.
   };
-  /** @brief Conjunto de ID's de ciudades ordenado árboreamente río arriba. */
-  BinTree<string> _id_ciudades;
-  /** @brief Contenedor donde relacionar ID con ciudad. */
-  map<string, Ciudad> _lista_ciudades;
+  /** @brief Cuentas de una planificación. */
+  struct Recuento {
+    long long aciertos; // Subárboles cuyo resultado se ha reutilizado.
+    long long fallos; // Nodos que se han vuelto a calcular.
+  };
+  /** @brief Aviso de cambio de un producto de una ciudad, guardado para más
+      tarde. Si id_producto < 0, es un aviso de totales con el peso en tiene
+      y el volumen en necesita. */
+  struct Aviso {
+    int ciudad, id_producto;
+    bool presente;
+    int tiene, necesita;
+  };
+  /** @brief Comercios de redistribuir agrupados en tramos, con sus dependencias. */
+  struct Tramos {
+    vector<int> inicio; // El tramo t son los comercios de los nodos [inicio[t], inicio[t+1]).
+    vector<int> primer; // Los sucesores de t son sucesores[primer[t]] .. sucesores[primer[t+1]-1].
+    vector<int> sucesores; // Tramos que esperan a cada tramo.
+    vector<atomic<int> > pendientes; // Predecesores de cada tramo que aún no han acabado.
+    vector<vector<Aviso> > avisos; // Avisos de las ciudades durante cada tramo, en orden.
+  };
+  /** @brief Donde guarda el hilo actual los avisos de las ciudades, o nulo si
+      se atienden en el momento. */
+  static thread_local vector<Aviso>* _avisos_hilo;
+  /** @brief Identificadores de las ciudades ordenados árboreamente río arriba. */
+  Rio _rio;
+  /** @brief Relación entre el nombre de cada ciudad y su identificador. */
+  Tabla_ciudades _nombres;
+  /** @brief Ciudades, indexadas por identificador. */
+  vector<Ciudad> _ciudades;
+  /** @brief Nodos del río de cada ciudad y, para planificar, nodos con
+      excedente o déficit de cada producto. */
+  Indice_excedentes _indice;
+  /** @brief Si los excedentes y déficits de _indice reflejan los inventarios y
+      se mantienen con los avisos. */
+  bool _excedentes_al_dia;
+  /** @brief Ciudades que tienen cada producto, estén o no en el río. */
+  Indice_productos _productos;
+  /** @brief Si _productos refleja los inventarios y se mantiene con los avisos. */
+  bool _productos_al_dia;
+  /** @brief Peso y volumen total de los subárboles del río. */
+  Totales_rio _totales;
+  /** @brief Si _totales refleja las ciudades y se mantiene con los avisos. */
+  bool _totales_al_dia;
+  /** @brief Hilos para las operaciones paralelas, o nulo para hacerlo todo en uno. */
+  Pool_hilos* _pool;
+  /** @brief Tamaño de subárbol por debajo del cual no se reparte el trabajo. */
+  int _corte;
+  /** @brief Último resultado de la planificación en cada nodo del río. */
+  vector<Paso> _plan;
+  /** @brief Nodos con algún cambio en su subárbol desde que se calculó su
+      resultado. Si un nodo está marcado, también lo están sus antecesores. */
+  vector<char> _sucio;
+  /** @brief Objetivo con el que se ha calculado _plan. */
+  Objetivo _objetivo_plan;
+  /** @brief Cuentas acumuladas de todas las planificaciones. */
+  Recuento _recuento;
   
   // Métodos privados
 
+  /** @brief Identificador de una ciudad, creándola si no existe.
+      \pre <em>cierto</em>
+      \post Devuelve el identificador de la ciudad de nombre t; si no existía,
+      se ha añadido una ciudad vacía con ese nombre.
+  */
+  int anadir_ciudad(const Token& t);
+
+  /** @brief Aviso de cambio de un producto de una ciudad.
+      \pre <em>cierto</em>
+      \post Los índices de la cuenca reflejan el nuevo estado del producto. Si el
+      hilo está haciendo un tramo de redistribuir, el aviso se guarda y se
+      atiende al acabar.
+  */
+  void producto_cambiado(int ciudad, int id_producto, bool presente, int tiene, int necesita);
+
+  /** @brief Aviso de cambio del peso y el volumen total de una ciudad.
+      \pre <em>cierto</em>
+      \post Si _totales está al día, sus nodos de la ciudad tienen los nuevos
+      totales. Si el hilo está guardando los avisos, se guarda y se atiende
+      al acabar.
+  */
+  void totales_cambiados(int ciudad, int peso, int volumen);
+
+  /** @brief Atiende un aviso guardado.
+      \pre <em>cierto</em>
+      \post Se ha atendido a como si llegara ahora de su ciudad.
+  */
+  void atender(const Aviso& a);
+
+  /** @brief Reconstruye los índices desde cero.
+      \pre <em>cierto</em>
+      \post Todas las ciudades avisan a la cuenca de sus cambios, los índices
+      reflejan el estado de todos los inventarios y no se reutiliza ningún
+      resultado de la planificación.
+  */
+  void reconstruir_indices();
+
+  /** @brief Descarta los resultados guardados de la planificación.
+      \pre <em>cierto</em>
+      \post _plan y _sucio tienen un elemento por nodo del río y ningún
+      resultado se puede reutilizar.
+  */
+  void reiniciar_plan();
+
+  /** @brief Marca los cambios de una ciudad.
+      \pre <em>cierto</em>
+      \post Los nodos de la ciudad y sus antecesores están marcados en _sucio.
+  */
+  void marcar_sucio(int ciudad);
+
   /** @brief Operación auxiliar de leer_rio.
-      \pre En el canal estándar de entrada se encuentran strings con nombres
+      \pre En el lector in se encuentran strings con nombres
       de ciudades y "#" que forman una estructura árborea binaria válida. 
-      \post Se ha leído un árbol binario desde el canal estándar de entrada en preorden.
-       Cada nodo contiene un nombre de ciudad, y los nodos hoja se representan con "#".
-       Se devuelve un BinTree<string> que representa la estructura leída.
+      \post Se ha leído un árbol binario desde el lector en preorden, en una
+       sola pasada y sin recursión. Cada nodo contiene un nombre de ciudad, y los
+       árboles vacíos se representan con "#" (o con el final de la entrada).
+       Se internan los nombres y _rio pasa a tener sus identificadores.
   */   
-  BinTree<string> leer_rio_rec();
+  void leer_estructura(Lector& in);
+
+  /** @brief Operación auxiliar de guardar_estado.
+      \pre <em>cierto</em>
+      \post Se ha escrito _rio en out en preorden: cada nodo con su
+      nombre y cada árbol vacío con longitud -1.
+  */
+  void guardar_estructura(Escritor_binario& out) const;
+
+  /** @brief Operación auxiliar de cargar_estado.
+      \pre En in se encuentra un árbol escrito con guardar_estructura.
+      \post Se internan los nombres y _rio pasa a ser el árbol leído.
+  */
+  void cargar_estructura(Lector_binario& in);
+
+  /** @brief Operación auxiliar de hacer_viaje.
+      \pre Las ciudades de la ruta existen.
+      \post Hace las compras y ventas pasando por la ruta y modificando las ciudades.
+  */
+  void hacer_camino(const vector<ElementoCamino>& ruta, const Cjt_productos& cp, Barco& b);
+
+  /** @brief Primera fase de la planificación en un nodo.
+      \pre El padre de i, si existe, ya está evaluado.
+      \post paso[i] tiene las unidades compradas y vendidas al llegar a i y las
+      que compra y vende en i, y el resultado de una ruta vacía. Devuelve falso
+      si el barco ya llega completo o si ningún nodo del subárbol de i tiene
+      excedente del producto a comprar ni déficit del producto a vender; en ese
+      caso i y su subárbol no aportan nada.
+  */
+  bool evaluar_nodo(int i, const Objetivo& o, vector<Paso>& paso) const;
+
+  /** @brief Segunda fase de la planificación en un nodo.
+      \pre i está evaluado y sus hijos tienen ya su resultado.
+      \post paso[i] tiene la mejor ruta que empieza en i.
+  */
+  void combinar_nodo(int i, vector<Paso>& paso) const;
+
+  /** @brief Consulta si el resultado guardado de un nodo sigue valiendo.
+      \pre El padre de i, si existe, ya está evaluado en _plan.
+      \post Devuelve cierto si el subárbol de i no ha cambiado desde que se
+      calculó su resultado y el barco llega a i con las mismas unidades.
+  */
+  bool reutilizable(int i) const;
+
+  /** @brief Invalida los resultados de un subárbol que no se recorre.
+      \pre i no está marcado en _sucio.
+      \post Ningún nodo del subárbol de i está marcado, y los que lo estaban
+      ya no tienen un resultado reutilizable.
+  */
+  void descartar_subarbol(int i);
+
+  /** @brief Visita un nodo en la primera fase de la planificación.
+      \pre El padre de i, si existe, ya está evaluado en _plan.
+      \post Devuelve cierto si i se ha evaluado y hay que seguir por sus hijos.
+      Si no, el resultado de i y de su subárbol ya está en _plan, reutilizado o
+      vacío. Se ha contado en r si se ha reutilizado o recalculado.
+  */
+  bool visitar_nodo(int i, const Objetivo& o, Recuento& r);
+
+  /** @brief Planifica un subárbol en el hilo actual.
+      \pre El padre de raiz, si existe, ya está evaluado en _plan.
+      \post Todos los nodos del subárbol de raiz que aportan algo tienen su
+      mejor ruta en _plan; en r se han sumado las cuentas.
+  */
+  void planificar_subarbol(int raiz, const Objetivo& o, Recuento& r);
+
+  /** @brief Planifica un subárbol repartiendo el trabajo entre los hilos.
+      \pre El padre de raiz, si existe, ya está evaluado en _plan; _pool no es nulo.
+      \post Igual que planificar_subarbol. Se baja por el hijo más grande y el
+      otro, si tiene al menos _corte nodos, se planifica a la vez como otra
+      tarea; el resultado es idéntico al de un solo hilo.
+  */
+  void planificar_paralelo(int raiz, const Objetivo& o, Recuento& r);
+
+  /** @brief Agrupa en tramos los comercios de redistribuir.
+      \pre <em>cierto</em>
+      \post Los comercios (padre, nodo) de los nodos que no son la desembocadura
+      están repartidos en tramos de nodos consecutivos en preorden: cada
+      subárbol de menos de _corte nodos con padre grande es un tramo, y cada
+      nodo con un subárbol mayor es un tramo él solo. Un tramo es sucesor de
+      otro si es el siguiente, en el orden del preorden, que toca alguna de
+      sus ciudades; pendientes tiene el número de predecesores de cada tramo.
+  */
+  void preparar_tramos(Tramos& tr) const;
+
+  /** @brief Ejecuta un tramo de redistribuir y los que se liberan con él.
+      \pre Los predecesores del tramo t han acabado; _pool no es nulo.
+      \post Se han hecho los comercios del tramo t y sus avisos están en
+      tr.avisos[t]. Los sucesores que han quedado sin predecesores pendientes se
+      han ejecutado también, uno en este mismo hilo y el resto lanzados en g.
+  */
+  void ejecutar_tramo(int t, Tramos& tr, const Cjt_productos& cp, Pool_hilos::Grupo& g);
+
+  /** @brief Planifica un viaje sin hacerlo.
+      \pre <em>cierto</em>
+      \post En v están la ruta que seguiría el barco b y las unidades que
+      compraría y vendería en ella: la ruta con más unidades desde la
+      desembocadura y, a igualdad, la más corta, prefiriendo la izquierda. No se
+      modifica ninguna ciudad.
+
+      Se hace en dos fases: de arriba abajo se reparten las unidades ya
+      compradas y vendidas, y de abajo arriba cada nodo guarda solo su mejor
+      resultado y el hijo por el que sigue. Al final se reconstruye la ruta
+      bajando una sola vez.
+
+      Los resultados de cada nodo se guardan de un viaje a otro. Un subárbol
+      sin cambios al que el barco llega con las mismas unidades no se vuelve a
+      recorrer, de modo que tras cambiar unas pocas ciudades solo se recalculan
+      sus caminos hasta la desembocadura. Si cambia lo que el barco compra o
+      vende, se recalcula todo.
+  */
+  void planificar(const Barco& b, Viaje& v);
+
+  /** @brief Lo que quiere comprar y vender un barco.
+      \pre <em>cierto</em>
+      \post Devuelve el objetivo de b.
+  */
+  static Objetivo objetivo(const Barco& b);
+
+  /** @brief Prepara el índice de productos para una consulta.
+      \pre <em>cierto</em>
+      \post _productos refleja los inventarios de todas las ciudades y se
+      mantiene al día con sus avisos. Si no lo estaba, se ha llenado de nuevo.
+  */
+  void preparar_productos();
 
-  /** @brief Operación auxiliar de redistribuir.
-      \pre El árbol t contiene nombres de ciudades correctos.
-      \post La ciudad en el nodo actual ha comerciado con la ciudad en su subárbol izquierdo, si existe.
-       Después de procesar el subárbol izquierdo, la ciudad en el nodo actual ha comerciado con la ciudad en su subárbol derecho, si existe.
-       La función se llama recursivamente para los subárboles izquierdo y derecho, siguiendo un recorrido en preorden.
-  */  
-  void redistribuir_rec(BinTree<string>& t, const Cjt_productos& cp);
+  /** @brief Prepara los excedentes y déficits del índice para planificar.
+      \pre <em>cierto</em>
+      \post _indice refleja los excedentes y déficits de todas las ciudades
+      del río y se mantiene al día con sus avisos. Si no lo estaba, se ha
+      llenado de nuevo.
+  */
+  void preparar_excedentes();
 
-  // FORMATO DOXYGEN
-  void hacer_camino(const list<ElementoCamino>& ruta, const Cjt_productos& cp, Barco& b); // Función auxiliar para la operación hacer viaje.
-  pair<int,int> encontrar_camino(const BinTree<string>& t, Barco& b, int compradas, int vendidas, list<ElementoCamino>& ruta); // Función auxiliar para la operación hacer viaje.
+  /** @brief Prepara los totales de los subárboles para una consulta.
+      \pre <em>cierto</em>
+      \post _totales refleja el peso y el volumen de todas las ciudades del
+      río y se mantiene al día con sus avisos. Si no lo estaba, se ha llenado
+      de nuevo.
+  */
+  void preparar_totales();
+
+  /** @brief Escribe un grupo de ciudades de un producto.
+      \pre <em>cierto</em>
+      \post Se ha escrito total y el número de ciudades del grupo g del
+      producto y, en orden de identificador, cada ciudad con lo que le sobra o
+      le falta.
+  */
+  void escribir_grupo(int id_producto, Indice_productos::Grupo g, long long total) const;
+
+  /** @brief Nodo del río de una ciudad para las consultas de caminos.
+      \pre <em>cierto</em>
+      \post Devuelve el primer nodo en preorden de la ciudad de nombre
+      id_ciudad. Si no existe o no está en el río, se ha escrito el error y
+      devuelve -1.
+  */
+  int nodo_camino(const string& id_ciudad) const;
+
+  /** @brief Reconstruye la ruta de una planificación.
+      \pre Los nodos de la mejor ruta desde la desembocadura tienen su resultado en paso.
+      \post En v están esa ruta y sus unidades compradas y vendidas.
+  */
+  void reconstruir(const vector<Paso>& paso, Viaje& v) const;
+
+  /** @brief Planifica un viaje sin los resultados guardados.
+      \pre <em>cierto</em>
+      \post En v está lo mismo que dejaría planificar() para el objetivo o,
+      sin usar ni modificar _plan; paso queda con resultados intermedios. Se
+      puede llamar a la vez desde varios hilos con distintos paso y v.
+  */
+  void evaluar_viaje(const Objetivo& o, vector<Paso>& paso, Viaje& v) const;
+
+  /** @brief Planifica varios viajes sin los resultados guardados.
+      \pre <em>cierto</em>
+      \post viajes[j] es lo que dejaría planificar() para objetivos[j]. Con
+      hilos, los objetivos se reparten entre ellos.
+  */
+  void evaluar_viajes(const vector<Objetivo>& objetivos, vector<Viaje>& viajes) const;
 
 public:
+  /** @brief Tamaño de subárbol por defecto por debajo del cual no se reparte el trabajo. */
+  static const int CORTE_PARALELO = 1 << 14;
+
   // Constructora
 
   /** @brief Creadora por defecto. 
@@ -69,22 +374,35 @@ public:
       \post El resultado es una cuenca no inicializada.
   */   
   Cuenca();
+
+  // Configuración
+
+  /** @brief Configura los hilos de las operaciones paralelas.
+      \pre pool es nulo o sigue existiendo mientras se use la cuenca; corte >= 1.
+      \post Las operaciones paralelizables se reparten en pool; un subárbol de
+      menos de corte nodos se procesa en un solo hilo.
+  */
+  void usar_hilos(Pool_hilos* pool, int corte);
   
   // Modificadoras
 
   /** @brief Lectura inicial del barco
-      \pre En el canal estándar de entrada se encuentra un entero no negativo, seguido
+      \pre En el lector in se encuentra un entero no negativo, seguido
       de una lista de productos no repetidos con el formato correcto, una estructura árborea 
       correcta de strings e ID's de comprar y vender válidas, num_comprar y vender > 0.
       \post Se hace la lectura de la cuenca, de los productos y del barco.
   */
 
-  void lectura_inicial(Cjt_productos& cp, Barco &b);
+  void lectura_inicial(Cjt_productos& cp, Barco &b, Lector& in);
 
   /** @brief Acción de redistribuir.
       \pre cp es un conjunto de productos válido, inicializado y consistente con los productos en las ciudades.
       \post La ciudad de la desembocaduraha comerciado con su ciudad río arriba a la derecha y
       luego con la ciudad río arriba a la izquierda, sucesivamente.
+
+      Con hilos, los comercios que no comparten ninguna ciudad se hacen a la
+      vez, respetando el orden entre los que sí la comparten, de modo que los
+      inventarios quedan exactamente igual que con un solo hilo.
   */
   void redistribuir(const Cjt_productos& cp);
 
@@ -96,6 +414,18 @@ public:
   */
   void hacer_viaje(Barco& b, const Cjt_productos& cp);
 
+  /** @brief Acción de hacer un viaje con cada barco de una lista.
+      \pre Los barcos están inicializados.
+      \post Igual que hacer_viaje() con cada barco, en orden: quien va antes
+      se queda con el excedente que quieran varios, y cada barco anota su
+      última ciudad.
+
+      Las rutas se planifican primero todas a la vez sobre el estado inicial.
+      Al hacerlas en orden, la de un barco con algún producto que ya ha
+      cambiado un viaje anterior se vuelve a planificar.
+  */
+  void hacer_viajes(const vector<Barco*>& barcos, const Cjt_productos& cp);
+
   /** @brief Acción de comerciar.
       \pre Las ID's de las ciudades representan ciudades con inventarios que contienen productos con IDs válidos y consistentes 
       respecto al conjunto de productos, que debe contener información válida sobre los productos, de sus pesos y volúmenes.
@@ -103,25 +433,38 @@ public:
       ciudad y que necesite la otra. Los inventarios de ambas ciudades se han actualizado.
       Los atributos de peso y volumen total de ambas ciudades se han ajustado adecuadamente.
   */
-  void comerciar(string id_ciudad1, string id_ciudad2, const Cjt_productos& cp);
+  void comerciar(const string& id_ciudad1, const string& id_ciudad2, const Cjt_productos& cp);
+
+  /** @brief Acción de comerciar varias parejas de ciudades.
+      \pre cp es un conjunto de productos válido, inicializado y consistente con los productos en las ciudades.
+      \post Igual que comerciar() con cada pareja de pares, en orden: cada
+      pareja con una ciudad que no existe o repetida escribe su error, en el
+      orden de pares, y las demás comercian.
+
+      Con hilos, los comercios se agrupan en rondas en las que ninguna ciudad
+      sale dos veces, y cada ronda se hace a la vez. Cada ciudad comercia en
+      el mismo orden que uno tras otro, así que los inventarios quedan
+      exactamente igual.
+  */
+  void comerciar_lote(const vector<pair<string, string> >& pares, const Cjt_productos& cp);
 
   /** @brief Modificadora para añadir producto a ciudad.
       \pre prod_tiene + prod_necesita > 0
       \post Añade el producto al inventario de la ciudad.
   */
-  void poner_prod(string id_ciudad, int id_producto, int prod_tiene, int prod_necesita, const Cjt_productos& cp);
+  void poner_prod(const string& id_ciudad, int id_producto, int prod_tiene, int prod_necesita, const Cjt_productos& cp);
 
   /** @brief Modificadora de producto de ciudad.
       \pre prod_tiene + prod_necesita > 0
       \post Modifica los datos del inventario de la ciudad.
   */
-  void modificar_prod(string id_ciudad, int id_producto, int prod_tiene, int prod_necesita, const Cjt_productos& cp);
+  void modificar_prod(const string& id_ciudad, int id_producto, int prod_tiene, int prod_necesita, const Cjt_productos& cp);
 
   /** @brief Modificadora para eliminar producto de ciudad.
       \pre <em>cierto</em>
       \post Quita un producto del inventario.
   */
-  void quitar_prod(string id_ciudad, int id_producto, const Cjt_productos& cp);
+  void quitar_prod(const string& id_ciudad, int id_producto, const Cjt_productos& cp);
   
   // Consultoras
 
@@ -129,19 +472,33 @@ public:
       \pre <em>cierto</em>
       \post Devuelve true si existe la ciudad, false de lo contrario.
   */
-  bool hay_ciudad(string id_ciudad) const;
+  bool hay_ciudad(const string& id_ciudad) const;
 
   /** @brief Consultora de existencia de producto en ciudad.
       \pre <em>cierto</em>
       \post Escribe true si el producto está en el inventario, falso de lo contrario.
   */
-  bool hay_prod_ciudad(string id_ciudad, int id_producto) const;
+  bool hay_prod_ciudad(const string& id_ciudad, int id_producto) const;
 
   /** @brief Operación para consultar un producto de una ciudad.
       \pre <em>cierto</em>
       \post Escribe cuántas unidades de ese producto tiene y necesita la ciudad indicada.
   */
-  void consultar_prod_ciudad(string id_ciudad, int id_producto, const Cjt_productos& cp) const;
+  void consultar_prod_ciudad(const string& id_ciudad, int id_producto, const Cjt_productos& cp) const;
+
+  /** @brief Consultora de los aciertos de la planificación.
+      \pre <em>cierto</em>
+      \post Devuelve cuántos subárboles se han reutilizado sin recorrerlos en
+      todas las planificaciones de viajes.
+  */
+  long long aciertos_plan() const;
+
+  /** @brief Consultora de los fallos de la planificación.
+      \pre <em>cierto</em>
+      \post Devuelve cuántos nodos se han tenido que volver a calcular en
+      todas las planificaciones de viajes.
+  */
+  long long fallos_plan() const;
 
  // Escritura
 
@@ -150,34 +507,125 @@ public:
       \post Se ha escrito el inventario, peso y volumen total de la ciudad en el canal estándard
       de salida.
   */
-  void escribir_ciudad(string id_ciudad) const;
+  void escribir_ciudad(const string& id_ciudad) const;
+
+  /** @brief Operación de escritura de los excedentes de un producto.
+      \pre <em>cierto</em>
+      \post Se ha escrito cuánto sobra del producto en total y en cuántas
+      ciudades y, en orden de identificador, cada una de esas ciudades con lo
+      que le sobra; o un error si el producto no existe. Cuesta lo que la
+      respuesta, sin recorrer las ciudades.
+
+      El índice de productos solo se mantiene a partir de la primera
+      consulta, que lo llena recorriendo los inventarios una vez; hasta
+      entonces los avisos de las ciudades no pagan nada por él. Se vuelve a
+      llenar tras leer el río o cargar un estado.
+  */
+  void escribir_excedentes(int id_producto, const Cjt_productos& cp);
+
+  /** @brief Operación de escritura de los déficits de un producto.
+      \pre <em>cierto</em>
+      \post Igual que escribir_excedentes con las ciudades a las que les falta
+      el producto y lo que les falta.
+  */
+  void escribir_deficits(int id_producto, const Cjt_productos& cp);
+
+  /** @brief Operación de escritura de los totales de la cuenca.
+      \pre <em>cierto</em>
+      \post Se ha escrito la suma de los excedentes y la de los déficits de
+      todos los productos en todas las ciudades.
+  */
+  void escribir_totales();
+
+  /** @brief Operación de escritura de los totales de un afluente.
+      \pre <em>cierto</em>
+      \post Se ha escrito el peso y el volumen total de las ciudades del
+      subárbol del primer nodo en preorden de la ciudad, ella incluida, o un
+      error si no existe o no está en el río, como en distancia_rio. Cuesta
+      un tiempo logarítmico en el tamaño del río.
+
+      Como el índice de productos, los totales solo se mantienen a partir de
+      la primera consulta, que los llena en un tiempo lineal.
+  */
+  void escribir_afluente(const string& id_ciudad);
+
+  /** @brief Operación de escritura de la distancia entre dos ciudades.
+      \pre <em>cierto</em>
+      \post Se ha escrito el número de tramos de río que separan el primer
+      nodo de cada ciudad, o un error si alguna no existe o no está en el río.
+      Cuesta un tiempo logarítmico en el tamaño del río.
+  */
+  void escribir_distancia(const string& id_ciudad1, const string& id_ciudad2) const;
+
+  /** @brief Operación de escritura del camino entre dos ciudades.
+      \pre <em>cierto</em>
+      \post Se ha escrito el número de ciudades del camino por el río entre el
+      primer nodo de cada ciudad y, en orden de id_ciudad1 a id_ciudad2, cada
+      una de ellas; o un error si alguna no existe o no está en el río. El
+      camino baja hasta el antecesor común de los dos nodos y sube desde él;
+      cuesta lo que la respuesta más un tiempo logarítmico.
+  */
+  void escribir_camino(const string& id_ciudad1, const string& id_ciudad2) const;
+
+  /** @brief Operación de escritura de viajes simulados.
+      \pre <em>cierto</em>
+      \post Para cada barco, en orden, se ha escrito el error de
+      modificar_barco si sus productos no son válidos y, si no, las unidades
+      que compraría y vendería en un viaje y la primera y la última ciudad de
+      su ruta, si no está vacía. No se modifica ninguna ciudad ni los
+      resultados guardados de hacer_viaje.
+
+      Con hilos, los barcos se reparten entre ellos: cada uno planifica desde
+      cero con su propio vector de pasos sobre el estado compartido.
+  */
+  void simular_viajes(const vector<Barco>& barcos, const Cjt_productos& cp);
 
   // Lectura
 
   /** @brief Operación de lectura de la estructura de la cuenca.
-      \pre En el canal estándar de entrada se encuentran strings con nombres
+      \pre En el lector in se encuentran strings con nombres
       de ciudades y "#" que forman una estructura árborea binaria válida. 
       \post Se han leído los nombres de las ciudades indicando la estructura de la cuenca.
   */
-  void leer_rio();
+  void leer_rio(Lector& in);
 
   /** @brief Operación de lectura de los inventarios de las ciudades.
-      \pre En el canal estándar de entrada se encuentran uno o más strings representando
+      \pre En el lector in se encuentran uno o más strings representando
       una ID de ciudad y por cada string, un entero no negativo. Posteriormente, se leen
       tres enteros el número de veces indicado por el anterior entero, todos 
       estrictamente positivos excepto el segundo que puede ser cero.
       \post Se han leído los inventarios de las ciudades.
   */
-  void leer_inventarios(const Cjt_productos& cp);    
+  void leer_inventarios(const Cjt_productos& cp, Lector& in);    
 
   /** @brief Operación de lectura de un inventario.
-      \pre En el canal estándar de entrada se encuentran un string representando
+      \pre En el lector in se encuentran un string representando
       una ID de ciudad y un entero no negativo. Posteriormente, se leen
       tres enteros el número de veces indicado por el anterior entero, todos 
       estrictamente positivos excepto el segundo que puede ser cero.
       \post Se ha leído el inventario de la ciudad.
   */
-  void leer_inventario(string id_ciudad, const Cjt_productos& cp);
+  void leer_inventario(const string& id_ciudad, const Cjt_productos& cp, Lector& in);
+
+  // Estado binario
+
+  /** @brief Guarda el estado completo de la simulación en un fichero binario.
+      \pre Barco inicializado.
+      \post Se ha escrito en el fichero una imagen con versión del conjunto de
+      productos, la estructura de la cuenca, los inventarios de las ciudades, el
+      barco y la flota, pensada para leerse de forma secuencial. Si no se ha
+      podido escribir se escribe un error y el fichero anterior, si existía, se
+      conserva.
+  */
+  void guardar_estado(const string& fichero, const Cjt_productos& cp, const Barco& b, const Flota& f) const;
+
+  /** @brief Recupera el estado completo de la simulación de una imagen binaria.
+      \pre in está al principio de la imagen.
+      \post Si in contiene una imagen válida escrita con guardar_estado, la
+      cuenca, cp, b y f pasan a ser los guardados y se devuelve cierto. Si no,
+      se escribe un error, no se modifica nada y se devuelve falso.
+  */
+  bool cargar_estado(Lector_binario& in, Cjt_productos& cp, Barco& b, Flota& f);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,146 @@
+/** @file Diario.cc
+    @brief Código de la clase Diario.
+*/
+
+#include "Diario.hh"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <ctime>
+
+// Un grupo se lleva a disco al llegar a este tamaño...
+static const size_t TAM_GRUPO = 1 << 16;
+// ...o cuando su primera anotación tiene esta antigüedad (ns).
+static const long long ESPERA_GRUPO = 10000000;
+
+// Pre: cierto.
+// Post: Devuelve el instante actual en nanosegundos de un reloj monótono.
+
+long long Diario::ahora() {
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+// Constructora
+
+// Pre: cierto.
+// Post: El resultado es un diario cerrado.
+
+Diario::Diario() : _fd(-1), _desde(0) {}
+
+// Pre: cierto.
+// Post: Se ha intentado confirmar lo pendiente y se ha cerrado el fichero.
+
+Diario::~Diario() {
+    confirmar();
+    if (_fd >= 0) close(_fd);
+}
+
+// Modificadoras
+
+// Pre: El diario está cerrado.
+// Post: Devuelve falso si no se ha podido abrir o crear el fichero. Si no,
+// se ha llamado a aplicar(codigo, args) con cada anotación completa del
+// fichero, en orden, y las siguientes anotaciones se añadirán al final.
+// En num se devuelve el número de anotaciones recuperadas.
+
+bool Diario::abrir(const string& fichero, const function<void(int, const Token&)>& aplicar, int& num) {
+    num = 0;
+    int fd = open(fichero.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return false;
+    }
+
+    size_t tam = st.st_size;
+    size_t valido = 0; // Final de la última anotación completa.
+    if (tam > 0) {
+        void* m = mmap(nullptr, tam, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        madvise(m, tam, MADV_SEQUENTIAL);
+        const unsigned char* p = (const unsigned char*)m;
+
+        size_t i = 0;
+        bool completa = true;
+        while (completa and i < tam) {
+            // Código (0 marca una zona sin escribir) y longitud en varint.
+            int codigo = int(p[i++]) - 1;
+            size_t lon = 0;
+            int desp = 0;
+            completa = codigo >= 0;
+            while (completa and i < tam and (p[i] & 0x80)) {
+                lon |= size_t(p[i++] & 0x7f) << desp;
+                desp += 7;
+            }
+            completa = completa and i < tam;
+            if (completa) {
+                lon |= size_t(p[i++]) << desp;
+                completa = lon <= tam - i;
+            }
+            if (completa) {
+                aplicar(codigo, Token{ (const char*)p + i, int(lon) });
+                i += lon;
+                valido = i;
+                ++num;
+            }
+        }
+        munmap(m, tam);
+    }
+
+    // Una anotación a medias es de una escritura interrumpida: se descarta.
+    if (valido < tam and ftruncate(fd, valido) < 0) {
+        close(fd);
+        return false;
+    }
+    _fd = fd;
+    return true;
+}
+
+// Pre: El diario está abierto, 0 <= codigo <= MAX_CODIGO.
+// Post: La anotación está en el grupo pendiente; si el grupo ya es grande o
+// antiguo, se ha intentado llevar a disco.
+
+void Diario::anotar(int codigo, const Token& args) {
+    if (_pendiente.empty()) _desde = ahora();
+    _pendiente.push_back(char(codigo + 1));
+    size_t lon = args.n;
+    while (lon >= 0x80) {
+        _pendiente.push_back(char((lon & 0x7f) | 0x80));
+        lon >>= 7;
+    }
+    _pendiente.push_back(char(lon));
+    _pendiente.insert(_pendiente.end(), args.p, args.p + args.n);
+
+    if (_pendiente.size() >= TAM_GRUPO or ahora() - _desde >= ESPERA_GRUPO) confirmar();
+}
+
+// Pre: cierto.
+// Post: Devuelve cierto si todo lo anotado está escrito y sincronizado en el
+// fichero. Si no, lo que no se ha podido escribir sigue pendiente.
+
+bool Diario::confirmar() {
+    if (_fd < 0 or _pendiente.empty()) return true;
+    size_t hecho = 0;
+    bool ok = true;
+    while (ok and hecho < _pendiente.size()) {
+        ssize_t k = write(_fd, _pendiente.data() + hecho, _pendiente.size() - hecho);
+        if (k < 0 and errno == EINTR) continue;
+        if (k <= 0) ok = false;
+        else hecho += k;
+    }
+    _pendiente.erase(_pendiente.begin(), _pendiente.begin() + hecho);
+    int r;
+    do {
+        r = fdatasync(_fd);
+    } while (r < 0 and errno == EINTR);
+    return ok and r == 0;
+}
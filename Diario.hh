@@ -0,0 +1,86 @@
+/** @file Diario.hh
+    @brief Especificación de la clase Diario.
+*/
+
+#ifndef _DIARIO_HH_
+#define _DIARIO_HH_
+
+#include "Lector.hh"
+
+#ifndef NO_DIAGRAM
+#include <functional>
+#endif
+
+/** @class Diario
+    @brief Diario de solo añadir con los comandos que modifican el estado.
+
+    Cada anotación guarda el código del comando y el texto de sus argumentos
+    tal como se leyeron: un byte con el código, la longitud en formato varint y
+    los argumentos. Las anotaciones se acumulan en memoria y se llevan a disco
+    por grupos (escritura + fdatasync) cuando el grupo es grande o su primera
+    anotación es lo bastante antigua, de modo que la sincronización no limita
+    el ritmo de comandos.
+
+    Al recuperar se vuelven a aplicar las anotaciones en orden. Si la última
+    quedó a medias por una caída, se descarta y se recorta el fichero.
+*/
+
+class Diario
+{
+
+private:
+  /** @brief Descriptor del fichero, -1 si el diario no está abierto. */
+  int _fd;
+  /** @brief Anotaciones aún no llevadas a disco. */
+  vector<char> _pendiente;
+  /** @brief Instante (ns) de la primera anotación pendiente. */
+  long long _desde;
+
+  /** @brief Instante actual en nanosegundos de un reloj monótono. */
+  static long long ahora();
+
+public:
+  /** @brief Mayor código que se puede anotar. */
+  static const int MAX_CODIGO = 254;
+
+  // Constructora
+
+  /** @brief Creadora por defecto.
+      \pre <em>cierto</em>
+      \post El resultado es un diario cerrado.
+  */
+  Diario();
+
+  /** @brief Destructora.
+      \pre <em>cierto</em>
+      \post Se ha intentado confirmar lo pendiente y se ha cerrado el fichero.
+  */
+  ~Diario();
+
+  // Modificadoras
+
+  /** @brief Abre un diario y recupera su contenido.
+      \pre El diario está cerrado.
+      \post Devuelve falso si no se ha podido abrir o crear el fichero. Si no,
+      se ha llamado a aplicar(codigo, args) con cada anotación completa del
+      fichero, en orden, y las siguientes anotaciones se añadirán al final.
+      En num se devuelve el número de anotaciones recuperadas.
+  */
+  bool abrir(const string& fichero, const function<void(int, const Token&)>& aplicar, int& num);
+
+  /** @brief Anota un comando.
+      \pre El diario está abierto, 0 <= codigo <= MAX_CODIGO.
+      \post La anotación está en el grupo pendiente; si el grupo ya es grande o
+      antiguo, se ha intentado llevar a disco.
+  */
+  void anotar(int codigo, const Token& args);
+
+  /** @brief Lleva a disco las anotaciones pendientes.
+      \pre <em>cierto</em>
+      \post Devuelve cierto si todo lo anotado está escrito y sincronizado en
+      el fichero. Si no, lo que no se ha podido escribir sigue pendiente.
+  */
+  bool confirmar();
+};
+
+#endif
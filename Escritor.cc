@@ -0,0 +1,132 @@
+/** @file Escritor.cc
+    @brief Código de la clase Escritor.
+*/
+
+#include "Escritor.hh"
+
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+// Tamaño del búfer: con la salida redirigida, una llamada a write() por MiB.
+static const size_t TAM_BUFER = 1 << 20;
+
+Escritor salida(1);
+
+// Constructora
+
+// Pre: fd es un descriptor abierto para escritura.
+// Post: El resultado es un escritor sin nada pendiente, no interactivo.
+
+Escritor::Escritor(int fd)
+    : _buf(TAM_BUFER), _n(0), _fd(fd), _interactivo(false), _silenciado(false),
+      _retenido(false), _antes_de_volcar(nullptr), _dato(nullptr) {}
+
+// Pre: cierto.
+// Post: Se ha volcado la salida pendiente.
+
+Escritor::~Escritor() {
+    volcar();
+}
+
+// Modificadoras
+
+// Pre: cierto.
+// Post: En modo interactivo volcar_interactivo() vuelca la salida pendiente.
+
+void Escritor::modo_interactivo(bool activo) {
+    _interactivo = activo;
+}
+
+// Pre: cierto.
+// Post: Antes de escribir nada en el descriptor se llamará a f(dato).
+
+void Escritor::antes_de_volcar(void (*f)(void*), void* dato) {
+    _antes_de_volcar = f;
+    _dato = dato;
+}
+
+// Pre: cierto.
+// Post: El búfer está vacío y su contenido se ha escrito en el descriptor.
+
+void Escritor::volcar() {
+    if (_n > 0 and _antes_de_volcar != nullptr) _antes_de_volcar(_dato);
+    size_t hecho = 0;
+    while (hecho < _n) {
+        ssize_t k = write(_fd, _buf.data() + hecho, _n - hecho);
+        if (k < 0 and errno == EINTR) continue;
+        if (k <= 0) break; // Destino cerrado: se descarta el resto.
+        hecho += k;
+    }
+    _n = 0;
+    // Lo que haya crecido mientras estaba retenido se devuelve.
+    if (_buf.size() > TAM_BUFER) vector<char>(TAM_BUFER).swap(_buf);
+}
+
+// Pre: cierto.
+// Post: Caben al menos n caracteres más en el búfer.
+
+void Escritor::ampliar(size_t n) {
+    _buf.resize(max(2 * _buf.size(), _n + n));
+}
+
+// Pre: cierto.
+// Post: Los n caracteres de p están en el búfer a continuación de los anteriores.
+
+void Escritor::escribir(const char* p, size_t n) {
+    while (n > 0) {
+        reservar(1);
+        size_t k = min(n, _buf.size() - _n);
+        memcpy(_buf.data() + _n, p, k);
+        _n += k;
+        p += k;
+        n -= k;
+    }
+}
+
+// Escritura
+
+// Pre: cierto.
+// Post: Se ha escrito x en decimal.
+
+Escritor& Escritor::operator<<(int x) {
+    if (_silenciado) return *this;
+    // Cifras de derecha a izquierda en un búfer local; en unsigned para que
+    // el entero mínimo no desborde al cambiarle el signo.
+    char cifras[12];
+    int i = sizeof(cifras);
+    unsigned int u = x < 0 ? 0u - (unsigned int)x : (unsigned int)x;
+    do {
+        cifras[--i] = char('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
+    if (x < 0) cifras[--i] = '-';
+    escribir(cifras + i, sizeof(cifras) - i);
+    return *this;
+}
+
+// Pre: cierto.
+// Post: Se ha escrito x en decimal.
+
+Escritor& Escritor::operator<<(long long x) {
+    if (_silenciado) return *this;
+    char cifras[21];
+    int i = sizeof(cifras);
+    unsigned long long u = x < 0 ? 0ull - (unsigned long long)x : (unsigned long long)x;
+    do {
+        cifras[--i] = char('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
+    if (x < 0) cifras[--i] = '-';
+    escribir(cifras + i, sizeof(cifras) - i);
+    return *this;
+}
+
+// Pre: s es una cadena terminada en '\0'.
+// Post: Se ha escrito s.
+
+Escritor& Escritor::operator<<(const char* s) {
+    if (not _silenciado) escribir(s, strlen(s));
+    return *this;
+}
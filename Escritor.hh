@@ -0,0 +1,160 @@
+/** @file Escritor.hh
+    @brief Especificación de la clase Escritor.
+*/
+
+#ifndef _ESCRITOR_HH_
+#define _ESCRITOR_HH_
+
+#ifndef NO_DIAGRAM
+#include <string>
+#include <vector>
+#endif
+
+using namespace std;
+
+/** @class Escritor
+    @brief Canal de salida con un búfer grande, sin iostreams.
+
+    Acumula la salida en memoria y la vuelca al descriptor con una sola
+    llamada a write() cuando el búfer se llena, al final del programa o, en
+    modo interactivo, cada vez que se pide con volcar_interactivo(). Los
+    enteros se formatean directamente sobre el búfer.
+
+    Mientras está silenciado descarta la salida sin llegar a formatearla.
+    Mientras está retenido no vuelca nada: el búfer crece si hace falta.
+*/
+
+class Escritor
+{
+
+private:
+  /** @brief Búfer de salida. */
+  vector<char> _buf;
+  /** @brief Número de caracteres pendientes de volcar. */
+  size_t _n;
+  /** @brief Descriptor de destino. */
+  int _fd;
+  /** @brief Cierto si se vuelca al terminar cada comando. */
+  bool _interactivo;
+  /** @brief Cierto si se descarta la salida. */
+  bool _silenciado;
+  /** @brief Cierto si no se puede volcar: el búfer crece en su lugar. */
+  bool _retenido;
+  /** @brief Función a la que se llama antes de cada volcado, o nula. */
+  void (*_antes_de_volcar)(void*);
+  /** @brief Argumento de _antes_de_volcar. */
+  void* _dato;
+
+  /** @brief Asegura espacio en el búfer.
+      \pre <em>cierto</em>
+      \post Caben al menos n caracteres más en el búfer sin volcar.
+  */
+  void reservar(size_t n) {
+    if (_buf.size() - _n < n) {
+      if (_retenido) ampliar(n);
+      else volcar();
+    }
+  }
+
+  /** @brief Amplía el búfer.
+      \pre <em>cierto</em>
+      \post Caben al menos n caracteres más en el búfer.
+  */
+  void ampliar(size_t n);
+
+  /** @brief Añade caracteres al búfer.
+      \pre <em>cierto</em>
+      \post Los n caracteres de p están en el búfer a continuación de los anteriores.
+  */
+  void escribir(const char* p, size_t n);
+
+public:
+  // Constructora
+
+  /** @brief Creadora sobre un descriptor.
+      \pre fd es un descriptor abierto para escritura.
+      \post El resultado es un escritor sin nada pendiente, no interactivo.
+  */
+  explicit Escritor(int fd);
+
+  /** @brief Destructora.
+      \pre <em>cierto</em>
+      \post Se ha volcado la salida pendiente.
+  */
+  ~Escritor();
+
+  // Modificadoras
+
+  /** @brief Activa o desactiva el modo interactivo.
+      \pre <em>cierto</em>
+      \post En modo interactivo volcar_interactivo() vuelca la salida pendiente.
+  */
+  void modo_interactivo(bool activo);
+
+  /** @brief Silencia o reactiva la salida.
+      \pre <em>cierto</em>
+      \post Mientras está silenciado, lo que se escribe se descarta.
+  */
+  void silenciar(bool activo) {
+    _silenciado = activo;
+  }
+
+  /** @brief Retiene o libera la salida.
+      \pre <em>cierto</em>
+      \post Mientras está retenido, nada se escribe en el descriptor, ni
+      siquiera al llenarse el búfer.
+  */
+  void retener(bool activo) {
+    _retenido = activo;
+  }
+
+  /** @brief Registra una función a la que llamar antes de cada volcado.
+      \pre <em>cierto</em>
+      \post Antes de escribir nada en el descriptor se llamará a f(dato).
+  */
+  void antes_de_volcar(void (*f)(void*), void* dato);
+
+  /** @brief Vuelca la salida pendiente.
+      \pre <em>cierto</em>
+      \post El búfer está vacío y su contenido se ha escrito en el descriptor.
+  */
+  void volcar();
+
+  /** @brief Vuelca la salida pendiente solo en modo interactivo.
+      \pre <em>cierto</em>
+      \post Si el escritor es interactivo, el búfer está vacío.
+  */
+  void volcar_interactivo() {
+    if (_interactivo) volcar();
+  }
+
+  // Escritura
+
+  /** @brief Escribe un carácter. */
+  Escritor& operator<<(char c) {
+    if (_silenciado) return *this;
+    reservar(1);
+    _buf[_n++] = c;
+    return *this;
+  }
+
+  /** @brief Escribe un entero en decimal. */
+  Escritor& operator<<(int x);
+
+  /** @brief Escribe un entero largo en decimal. */
+  Escritor& operator<<(long long x);
+
+  /** @brief Escribe una cadena terminada en '\\0'. */
+  Escritor& operator<<(const char* s);
+
+  /** @brief Escribe un string. */
+  Escritor& operator<<(const string& s) {
+    if (not _silenciado) escribir(s.data(), s.size());
+    return *this;
+  }
+};
+
+/** @brief Canal estándar de salida del programa. */
+extern Escritor salida;
+
+#endif
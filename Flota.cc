@@ -0,0 +1,95 @@
+/** @file Flota.cc
+    @brief Código de la clase Flota.
+*/
+
+#include "Flota.hh"
+
+// Constructora
+
+// Pre: cierto.
+// Post: El resultado es una flota sin barcos.
+
+Flota::Flota() {
+}
+
+// Modificadoras
+
+// Pre: num_comprar > 0, num_vender > 0.
+// Post: El barco id pasa a comprar y vender esos productos, y si no existía
+// se añade. Si los productos no son válidos se escribe el error y la flota no
+// cambia.
+
+void Flota::modificar_barco(int id, int id_producto_comprar, int num_comprar, int id_producto_vender, int num_vender, const Cjt_productos& cp) {
+    map<int, Barco>::iterator it = _barcos.find(id);
+    if (it != _barcos.end()) {
+        it->second.modificar_barco(id_producto_comprar, num_comprar, id_producto_vender, num_vender, cp);
+    } else {
+        Barco b;
+        if (b.modificar_barco(id_producto_comprar, num_comprar, id_producto_vender, num_vender, cp)) {
+            _barcos.insert(make_pair(id, b));
+        }
+    }
+}
+
+// Pre: cierto.
+// Post: Todos los barcos tienen la lista de últimas ciudades vacía.
+
+void Flota::reiniciar_listas() {
+    for (map<int, Barco>::iterator it = _barcos.begin(); it != _barcos.end(); ++it) {
+        it->second.reiniciar_lista();
+    }
+}
+
+// Pre: cierto.
+// Post: Se ha escrito un error por cada identificador sin barco, en orden, y
+// c ha hecho hacer_viajes con los barcos que existen, en el orden de ids.
+
+void Flota::hacer_viajes(const vector<int>& ids, Cuenca& c, const Cjt_productos& cp) {
+    vector<Barco*> barcos;
+    barcos.reserve(ids.size());
+    for (int k = 0; k < int(ids.size()); ++k) {
+        map<int, Barco>::iterator it = _barcos.find(ids[k]);
+        if (it == _barcos.end()) salida << "error: no existe el barco\n";
+        else barcos.push_back(&it->second);
+    }
+    c.hacer_viajes(barcos, cp);
+}
+
+// Escritura
+
+// Pre: cierto.
+// Post: Se ha escrito el barco id como escribir_barco, o un error si no existe.
+
+void Flota::escribir_barco(int id) const {
+    map<int, Barco>::const_iterator it = _barcos.find(id);
+    if (it == _barcos.end()) salida << "error: no existe el barco\n";
+    else it->second.escribir_barco();
+}
+
+// Estado binario
+
+// Pre: cierto.
+// Post: Se han escrito en out el número de barcos y, en orden de
+// identificador, cada identificador con su barco.
+
+void Flota::guardar(Escritor_binario& out) const {
+    out.entero(_barcos.size());
+    for (map<int, Barco>::const_iterator it = _barcos.begin(); it != _barcos.end(); ++it) {
+        out.entero(it->first);
+        it->second.guardar(out);
+    }
+}
+
+// Pre: El parámetro implícito está vacío. En in se encuentra una flota escrita con guardar.
+// Post: El parámetro implícito contiene los barcos leídos. Devuelve falso si
+// los productos de algún barco no existen en cp.
+
+bool Flota::cargar(Lector_binario& in, const Cjt_productos& cp) {
+    int num_barcos = in.entero();
+    bool valido = true;
+    for (int i = 0; i < num_barcos and in.ok() and valido; ++i) {
+        int id = in.entero();
+        valido = _barcos[id].cargar(in, cp);
+    }
+    return valido;
+}
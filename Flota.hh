@@ -0,0 +1,91 @@
+/** @file Flota.hh
+    @brief Especificación de la clase Flota.
+*/
+
+#ifndef _FLOTA_HH_
+#define _FLOTA_HH_
+
+#include "Barco.hh"
+#include "Cuenca.hh"
+
+#ifndef NO_DIAGRAM
+#include <map>
+#include <vector>
+#endif
+
+using namespace std;
+
+/** @class Flota
+    @brief Conjunto de barcos identificados por un entero.
+
+    Cada barco tiene sus propios productos a comprar y vender y su propia
+    lista de últimas ciudades. Un barco existe desde que se configura por
+    primera vez con productos válidos.
+*/
+
+class Flota
+{
+
+private:
+  /** @brief Barcos de la flota, por identificador. */
+  map<int, Barco> _barcos;
+
+public:
+  // Constructora
+
+  /** @brief Creadora por defecto.
+      \pre <em>cierto</em>
+      \post El resultado es una flota sin barcos.
+  */
+  Flota();
+
+  // Modificadoras
+
+  /** @brief Modificadora de un barco de la flota.
+      \pre num_comprar > 0, num_vender > 0.
+      \post El barco id pasa a comprar y vender esos productos, y si no
+      existía se añade con la lista de ciudades vacía. Si los productos no son
+      válidos se escribe el error de modificar_barco y la flota no cambia.
+  */
+  void modificar_barco(int id, int id_producto_comprar, int num_comprar, int id_producto_vender, int num_vender, const Cjt_productos& cp);
+
+  /** @brief Modificadora para reiniciar las ciudades visitadas.
+      \pre <em>cierto</em>
+      \post Todos los barcos tienen la lista de últimas ciudades vacía.
+  */
+  void reiniciar_listas();
+
+  /** @brief Acción de hacer un viaje con varios barcos.
+      \pre <em>cierto</em>
+      \post Se ha escrito un error por cada identificador sin barco, en orden,
+      y después c ha hecho hacer_viajes con los barcos que existen, en el
+      orden de ids.
+  */
+  void hacer_viajes(const vector<int>& ids, Cuenca& c, const Cjt_productos& cp);
+
+  // Escritura
+
+  /** @brief Operación de escritura de un barco de la flota.
+      \pre <em>cierto</em>
+      \post Se ha escrito el barco id como escribir_barco, o un error si no existe.
+  */
+  void escribir_barco(int id) const;
+
+  // Estado binario
+
+  /** @brief Guarda la flota en un estado binario.
+      \pre <em>cierto</em>
+      \post Se han escrito en out el número de barcos y, en orden de
+      identificador, cada identificador con su barco.
+  */
+  void guardar(Escritor_binario& out) const;
+
+  /** @brief Carga la flota de un estado binario.
+      \pre El parámetro implícito está vacío. En in se encuentra una flota escrita con guardar.
+      \post El parámetro implícito contiene los barcos leídos. Devuelve falso
+      si los productos de algún barco no existen en cp.
+  */
+  bool cargar(Lector_binario& in, const Cjt_productos& cp);
+};
+
+#endif
@@ -0,0 +1,69 @@
+/** @file Indice_excedentes.cc
+    @brief Código de la clase Indice_excedentes.
+*/
+
+#include "Indice_excedentes.hh"
+
+// Pre: cierto.
+// Post: Devuelve cierto si el conjunto del producto indicado tiene alguna
+// posición en [desde, hasta).
+
+bool Indice_excedentes::hay_en(const vector<set<int> >& v, int id_producto, int desde, int hasta) {
+    if (id_producto < 0 or id_producto >= int(v.size())) return false;
+    set<int>::const_iterator it = v[id_producto].lower_bound(desde);
+    return it != v[id_producto].end() and *it < hasta;
+}
+
+// Modificadoras
+
+// Pre: Las ciudades del río son menores que num_ciudades.
+// Post: El índice no tiene ningún excedente ni déficit y conoce los nodos
+// de cada ciudad del río.
+
+void Indice_excedentes::reiniciar(const Rio& rio, int num_ciudades) {
+    _nodos.assign(num_ciudades, vector<int>());
+    for (int i = 0; i < rio.tamano(); ++i) _nodos[rio.ciudad(i)].push_back(i);
+    vaciar();
+}
+
+// Pre: cierto.
+// Post: El índice no tiene ningún excedente ni déficit y sigue conociendo
+// los nodos de cada ciudad.
+
+void Indice_excedentes::vaciar() {
+    _excedentes.clear();
+    _deficits.clear();
+}
+
+// Pre: cierto.
+// Post: Los nodos de la ciudad constan con excedente o déficit del producto
+// según tiene y necesita, o con ninguno de los dos si no está presente.
+
+void Indice_excedentes::actualizar(int ciudad, int id_producto, bool presente, int tiene, int necesita) {
+    // Las ciudades que no están en el río no tienen nodos.
+    if (ciudad >= int(_nodos.size()) or _nodos[ciudad].empty() or id_producto < 0) return;
+    if (id_producto >= int(_excedentes.size())) {
+        _excedentes.resize(id_producto + 1);
+        _deficits.resize(id_producto + 1);
+    }
+    int sobra = tiene - necesita;
+    const vector<int>& nodos = _nodos[ciudad];
+    for (int k = 0; k < int(nodos.size()); ++k) {
+        if (presente and sobra > 0) _excedentes[id_producto].insert(nodos[k]);
+        else _excedentes[id_producto].erase(nodos[k]);
+        if (presente and sobra < 0) _deficits[id_producto].insert(nodos[k]);
+        else _deficits[id_producto].erase(nodos[k]);
+    }
+}
+
+// Consultoras
+
+// Pre: cierto.
+// Post: Devuelve las posiciones en preorden de los nodos del río de la
+// ciudad, vacío si no está en el río.
+
+const vector<int>& Indice_excedentes::nodos(int ciudad) const {
+    static const vector<int> ninguno;
+    if (ciudad < 0 or ciudad >= int(_nodos.size())) return ninguno;
+    return _nodos[ciudad];
+}
@@ -0,0 +1,106 @@
+/** @file Indice_excedentes.hh
+    @brief Especificación de la clase Indice_excedentes.
+*/
+
+#ifndef _INDICE_EXCEDENTES_HH_
+#define _INDICE_EXCEDENTES_HH_
+
+#include "Rio.hh"
+#include "Ciudad.hh"
+
+#ifndef NO_DIAGRAM
+#include <set>
+#endif
+
+/** @class Indice_excedentes
+    @brief Para cada producto, nodos del río con excedente y con déficit.
+
+    Un nodo tiene excedente de un producto si su ciudad lo tiene en el
+    inventario con más unidades de las que necesita, y déficit si tiene menos.
+    Para cada producto se guardan ordenadas las posiciones en preorden de los
+    nodos con excedente y las de los nodos con déficit. Como el subárbol de un
+    nodo ocupa posiciones consecutivas, saber si algún nodo de un subárbol tiene
+    excedente o déficit cuesta una búsqueda logarítmica.
+
+    Se mantiene al día con los avisos de cambio de las ciudades. Si una ciudad
+    aparece en varios nodos, se actualizan todos. Es un observador de
+    ciudades, así que se puede llenar con Ciudad::avisar_inventario().
+*/
+
+class Indice_excedentes : public Ciudad::Observador
+{
+
+private:
+  /** @brief Nodos del río de cada ciudad. */
+  vector<vector<int> > _nodos;
+  /** @brief Posiciones de los nodos con excedente de cada producto. */
+  vector<set<int> > _excedentes;
+  /** @brief Posiciones de los nodos con déficit de cada producto. */
+  vector<set<int> > _deficits;
+
+  /** @brief Consulta de un conjunto de posiciones.
+      \pre <em>cierto</em>
+      \post Devuelve cierto si el conjunto del producto indicado tiene alguna
+      posición en [desde, hasta).
+  */
+  static bool hay_en(const vector<set<int> >& v, int id_producto, int desde, int hasta);
+
+public:
+  // Modificadoras
+
+  /** @brief Prepara el índice para un río.
+      \pre Las ciudades del río son menores que num_ciudades.
+      \post El índice no tiene ningún excedente ni déficit y conoce los nodos
+      de cada ciudad del río.
+  */
+  void reiniciar(const Rio& rio, int num_ciudades);
+
+  /** @brief Vacía los excedentes y déficits.
+      \pre <em>cierto</em>
+      \post El índice no tiene ningún excedente ni déficit y sigue conociendo
+      los nodos de cada ciudad.
+  */
+  void vaciar();
+
+  /** @brief Actualiza el índice tras un cambio en una ciudad.
+      \pre <em>cierto</em>
+      \post Los nodos de la ciudad constan con excedente o déficit del producto
+      según tiene y necesita, o con ninguno de los dos si no está presente.
+  */
+  void actualizar(int ciudad, int id_producto, bool presente, int tiene, int necesita);
+
+  /** @brief Aviso de cambio de un producto de una ciudad.
+      \pre <em>cierto</em>
+      \post Igual que actualizar().
+  */
+  void producto_cambiado(int ciudad, int id_producto, bool presente, int tiene, int necesita) {
+    actualizar(ciudad, id_producto, presente, tiene, necesita);
+  }
+
+  // Consultoras
+
+  /** @brief Consultora de los nodos de una ciudad.
+      \pre <em>cierto</em>
+      \post Devuelve las posiciones en preorden de los nodos del río de la
+      ciudad, vacío si no está en el río.
+  */
+  const vector<int>& nodos(int ciudad) const;
+
+  /** @brief Consultora de excedentes en un rango de nodos.
+      \pre <em>cierto</em>
+      \post Devuelve cierto si algún nodo de [desde, hasta) tiene excedente del producto.
+  */
+  bool hay_excedente(int id_producto, int desde, int hasta) const {
+    return hay_en(_excedentes, id_producto, desde, hasta);
+  }
+
+  /** @brief Consultora de déficits en un rango de nodos.
+      \pre <em>cierto</em>
+      \post Devuelve cierto si algún nodo de [desde, hasta) tiene déficit del producto.
+  */
+  bool hay_deficit(int id_producto, int desde, int hasta) const {
+    return hay_en(_deficits, id_producto, desde, hasta);
+  }
+};
+
+#endif
@@ -0,0 +1,195 @@
+/** @file Indice_productos.cc
+    @brief Código de la clase Indice_productos.
+*/
+
+#include "Indice_productos.hh"
+
+// Número de posiciones de una tabla vacía (potencia de dos).
+static const int TAM_INICIAL = 16;
+
+// Pre: La tabla tiene posiciones libres.
+// Post: Devuelve la posición que ocupa la pareja o, si no está, la posición
+// libre donde iría.
+
+int Indice_productos::ranura(int ciudad, int id_producto) const {
+    unsigned int mascara = _tabla.size() - 1;
+    unsigned int i = hash(ciudad, id_producto) & mascara;
+    while (_tabla[i].ciudad >= 0) {
+        if (_tabla[i].ciudad == ciudad and _tabla[i].id_producto == id_producto) return i;
+        i = (i + 1) & mascara;
+    }
+    return i;
+}
+
+// Pre: La posición r está ocupada.
+// Post: La pareja de r ya no está y las demás se encuentran igual.
+
+void Indice_productos::liberar(int r) {
+    // Sin marcas de borrado: las parejas que venían detrás y podrían ir en el
+    // hueco se mueven hacia atrás, así ningún sondeo se corta antes de tiempo.
+    unsigned int mascara = _tabla.size() - 1;
+    unsigned int hueco = r;
+    unsigned int j = r;
+    _tabla[hueco].ciudad = -1;
+    while (true) {
+        j = (j + 1) & mascara;
+        if (_tabla[j].ciudad < 0) return;
+        unsigned int ideal = hash(_tabla[j].ciudad, _tabla[j].id_producto) & mascara;
+        // La pareja de j se queda si su posición ideal está entre el hueco
+        // (sin incluirlo) y j, contando circularmente.
+        if (((j - ideal) & mascara) < ((j - hueco) & mascara)) continue;
+        _tabla[hueco] = _tabla[j];
+        _tabla[j].ciudad = -1;
+        hueco = j;
+    }
+}
+
+// Pre: cierto.
+// Post: La tabla tiene el doble de posiciones y las mismas parejas.
+
+void Indice_productos::crecer() {
+    vector<Ranura> vieja(2 * _tabla.size());
+    for (int i = 0; i < int(vieja.size()); ++i) vieja[i].ciudad = -1;
+    vieja.swap(_tabla);
+    unsigned int mascara = _tabla.size() - 1;
+    for (int k = 0; k < int(vieja.size()); ++k) {
+        if (vieja[k].ciudad < 0) continue;
+        unsigned int i = hash(vieja[k].ciudad, vieja[k].id_producto) & mascara;
+        while (_tabla[i].ciudad >= 0) i = (i + 1) & mascara;
+        _tabla[i] = vieja[k];
+    }
+}
+
+// Pre: signo es 1 o -1.
+// Post: Las sumas del producto y las totales han cambiado en signo veces lo
+// que le sobra o le falta a t.
+
+void Indice_productos::contar(int id_producto, const Tenencia& t, int signo) {
+    long long sobra = (long long)signo * (t.tiene - t.necesita);
+    if (t.tiene > t.necesita) {
+        _productos[id_producto].excedente += sobra;
+        _excedente_total += sobra;
+    } else {
+        _productos[id_producto].deficit -= sobra;
+        _deficit_total -= sobra;
+    }
+}
+
+// Pre: cierto.
+// Post: t está al final del grupo g del producto, sus unidades cuentan en las
+// sumas y se devuelve su posición codificada como en Ranura.
+
+int Indice_productos::meter(int id_producto, int g, const Tenencia& t) {
+    vector<Tenencia>& v = _productos[id_producto].grupo[g];
+    v.push_back(t);
+    contar(id_producto, t, 1);
+    return 4 * (int(v.size()) - 1) + g;
+}
+
+// Pre: pos es la posición codificada de una ciudad del producto.
+// Post: La ciudad ya no está en su grupo ni cuenta en las sumas.
+
+void Indice_productos::sacar(int id_producto, int pos) {
+    vector<Tenencia>& v = _productos[id_producto].grupo[pos & 3];
+    int i = pos >> 2;
+    contar(id_producto, v[i], -1);
+    // El último ocupa el hueco.
+    if (i != int(v.size()) - 1) {
+        v[i] = v.back();
+        _tabla[ranura(v[i].ciudad, id_producto)].pos = pos;
+    }
+    v.pop_back();
+}
+
+// Constructora
+
+// Pre: cierto.
+// Post: El resultado es un índice vacío.
+
+Indice_productos::Indice_productos() {
+    reiniciar();
+}
+
+// Modificadoras
+
+// Pre: cierto.
+// Post: Ninguna ciudad tiene ningún producto y las sumas son cero.
+
+void Indice_productos::reiniciar() {
+    _productos.clear();
+    _tabla.resize(TAM_INICIAL);
+    for (int i = 0; i < TAM_INICIAL; ++i) _tabla[i].ciudad = -1;
+    _num_parejas = 0;
+    _excedente_total = _deficit_total = 0;
+}
+
+// Pre: id_producto >= 0.
+// Post: La ciudad consta con el producto y sus unidades en el grupo que le
+// toca, o sin él si no está presente, y las sumas están al día.
+
+void Indice_productos::actualizar(int ciudad, int id_producto, bool presente, int tiene, int necesita) {
+    if (id_producto >= int(_productos.size())) {
+        Producto vacio;
+        vacio.excedente = vacio.deficit = 0;
+        _productos.resize(id_producto + 1, vacio);
+    }
+    int r = ranura(ciudad, id_producto);
+    bool estaba = _tabla[r].ciudad >= 0;
+    if (not presente) {
+        if (estaba) {
+            sacar(id_producto, _tabla[r].pos);
+            liberar(r);
+            --_num_parejas;
+        }
+        return;
+    }
+
+    Tenencia t = { ciudad, tiene, necesita };
+    int g = grupo_de(tiene - necesita);
+    if (not estaba) {
+        _tabla[r].ciudad = ciudad;
+        _tabla[r].id_producto = id_producto;
+        _tabla[r].pos = meter(id_producto, g, t);
+        // Se mantiene la tabla medio vacía para que los sondeos sean cortos.
+        if (2 * ++_num_parejas > int(_tabla.size())) crecer();
+    } else if ((_tabla[r].pos & 3) == g) {
+        // Sigue en el mismo grupo: se cambian las unidades en su sitio.
+        Tenencia& v = _productos[id_producto].grupo[g][_tabla[r].pos >> 2];
+        contar(id_producto, v, -1);
+        v = t;
+        contar(id_producto, v, 1);
+    } else {
+        sacar(id_producto, _tabla[r].pos);
+        _tabla[r].pos = meter(id_producto, g, t);
+    }
+}
+
+// Consultoras
+
+// Pre: cierto.
+// Post: Devuelve las ciudades del grupo g del producto, sin orden; vacío si
+// ninguna lo tiene.
+
+const vector<Indice_productos::Tenencia>& Indice_productos::ciudades(int id_producto, Grupo g) const {
+    static const vector<Tenencia> ninguna;
+    if (id_producto < 0 or id_producto >= int(_productos.size())) return ninguna;
+    return _productos[id_producto].grupo[g];
+}
+
+// Pre: cierto.
+// Post: Devuelve la suma de tiene - necesita de las ciudades a las que les
+// sobra el producto.
+
+long long Indice_productos::excedente(int id_producto) const {
+    if (id_producto < 0 or id_producto >= int(_productos.size())) return 0;
+    return _productos[id_producto].excedente;
+}
+
+// Pre: cierto.
+// Post: Devuelve la suma de necesita - tiene de las ciudades a las que les
+// falta el producto.
+
+long long Indice_productos::deficit(int id_producto) const {
+    if (id_producto < 0 or id_producto >= int(_productos.size())) return 0;
+    return _productos[id_producto].deficit;
+}
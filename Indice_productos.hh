@@ -0,0 +1,192 @@
+/** @file Indice_productos.hh
+    @brief Especificación de la clase Indice_productos.
+*/
+
+#ifndef _INDICE_PRODUCTOS_HH_
+#define _INDICE_PRODUCTOS_HH_
+
+#include "Ciudad.hh"
+
+#ifndef NO_DIAGRAM
+#include <vector>
+#endif
+
+using namespace std;
+
+/** @class Indice_productos
+    @brief Para cada producto, las ciudades que lo tienen en el inventario.
+
+    Es el índice inverso de los inventarios: para cada producto se guardan las
+    ciudades que lo tienen, con las unidades que tienen y necesitan, repartidas
+    en tres grupos según les sobre, les falte o tengan justo lo que necesitan.
+    Cada grupo es un vector sin orden del que se quita cambiando el elemento
+    por el último, y dónde está cada pareja (ciudad, producto) se guarda en una
+    tabla de dispersión con direccionamiento abierto, como la de
+    Tabla_ciudades pero sin memoria aparte por elemento. Así cada aviso cuesta
+    tiempo constante y listar las ciudades con excedente o déficit de un
+    producto cuesta lo que la respuesta.
+
+    También se llevan la suma de los excedentes y de los déficits de cada
+    producto y de todos a la vez. A diferencia de Indice_excedentes, cuenta
+    todas las ciudades, estén o no en el río. Es un observador de ciudades,
+    así que se puede llenar con Ciudad::avisar_inventario().
+*/
+
+class Indice_productos : public Ciudad::Observador
+{
+
+public:
+  /** @brief Producto de una ciudad. */
+  struct Tenencia {
+    int ciudad; // Identificador de la ciudad.
+    int tiene, necesita; // Unidades que tiene y que necesita.
+  };
+
+  /** @brief Grupos de ciudades de un producto. */
+  enum Grupo { EXCEDENTE = 0, DEFICIT = 1, EQUILIBRIO = 2 };
+
+private:
+  /** @brief Ciudades que tienen un producto y lo que les sobra o falta en total. */
+  struct Producto {
+    vector<Tenencia> grupo[3]; // Ciudades de cada grupo, sin orden.
+    long long excedente, deficit; // Suma de lo que sobra y de lo que falta.
+  };
+  /** @brief Posición de la tabla de dispersión. */
+  struct Ranura {
+    int ciudad, id_producto; // Pareja guardada; ciudad < 0 si está libre.
+    int pos; // 4 * posición dentro del grupo + grupo.
+  };
+  /** @brief Ciudades de cada producto, por identificador. */
+  vector<Producto> _productos;
+  /** @brief Tabla de dispersión (potencia de dos) de las parejas presentes. */
+  vector<Ranura> _tabla;
+  /** @brief Número de parejas presentes. */
+  int _num_parejas;
+  /** @brief Suma de los excedentes de todos los productos. */
+  long long _excedente_total;
+  /** @brief Suma de los déficits de todos los productos. */
+  long long _deficit_total;
+
+  /** @brief Función de dispersión de una pareja.
+      \pre <em>cierto</em>
+      \post Devuelve el hash de (ciudad, id_producto).
+  */
+  static unsigned int hash(int ciudad, int id_producto) {
+    unsigned int h = (unsigned int)ciudad * 0x9E3779B1u ^ (unsigned int)id_producto * 0x85EBCA6Bu;
+    return h ^ (h >> 15);
+  }
+
+  /** @brief Posición de una pareja en la tabla.
+      \pre La tabla tiene posiciones libres.
+      \post Devuelve la posición que ocupa la pareja o, si no está, la
+      posición libre donde iría.
+  */
+  int ranura(int ciudad, int id_producto) const;
+
+  /** @brief Libera una posición de la tabla.
+      \pre La posición r está ocupada.
+      \post La pareja de r ya no está y las demás se encuentran igual.
+  */
+  void liberar(int r);
+
+  /** @brief Duplica el tamaño de la tabla.
+      \pre <em>cierto</em>
+      \post La tabla tiene el doble de posiciones y las mismas parejas.
+  */
+  void crecer();
+
+  /** @brief Grupo de unas unidades.
+      \pre <em>cierto</em>
+      \post Devuelve EXCEDENTE si sobra > 0, DEFICIT si sobra < 0 y EQUILIBRIO si no.
+  */
+  static int grupo_de(int sobra) {
+    return sobra > 0 ? EXCEDENTE : sobra < 0 ? DEFICIT : EQUILIBRIO;
+  }
+
+  /** @brief Suma o resta de las sumas lo que sobra o falta a una ciudad.
+      \pre signo es 1 o -1.
+      \post Las sumas del producto y las totales han cambiado en signo veces
+      lo que le sobra o le falta a t.
+  */
+  void contar(int id_producto, const Tenencia& t, int signo);
+
+  /** @brief Añade una ciudad a un grupo de un producto.
+      \pre <em>cierto</em>
+      \post t está al final del grupo g del producto, sus unidades cuentan en
+      las sumas y se devuelve su posición codificada como en Ranura.
+  */
+  int meter(int id_producto, int g, const Tenencia& t);
+
+  /** @brief Quita una ciudad de un grupo de un producto.
+      \pre pos es la posición codificada de una ciudad del producto.
+      \post La ciudad ya no está en su grupo ni cuenta en las sumas.
+  */
+  void sacar(int id_producto, int pos);
+
+public:
+  // Constructora
+
+  /** @brief Creadora por defecto.
+      \pre <em>cierto</em>
+      \post El resultado es un índice vacío.
+  */
+  Indice_productos();
+
+  // Modificadoras
+
+  /** @brief Vacía el índice.
+      \pre <em>cierto</em>
+      \post Ninguna ciudad tiene ningún producto y las sumas son cero.
+  */
+  void reiniciar();
+
+  /** @brief Actualiza el índice tras un cambio en una ciudad.
+      \pre id_producto >= 0.
+      \post La ciudad consta con el producto y sus unidades en el grupo que le
+      toca, o sin él si no está presente, y las sumas están al día.
+  */
+  void actualizar(int ciudad, int id_producto, bool presente, int tiene, int necesita);
+
+  /** @brief Aviso de cambio de un producto de una ciudad.
+      \pre id_producto >= 0.
+      \post Igual que actualizar().
+  */
+  void producto_cambiado(int ciudad, int id_producto, bool presente, int tiene, int necesita) {
+    actualizar(ciudad, id_producto, presente, tiene, necesita);
+  }
+
+  // Consultoras
+
+  /** @brief Consultora de las ciudades de un grupo.
+      \pre <em>cierto</em>
+      \post Devuelve las ciudades del grupo g del producto, sin orden; vacío
+      si ninguna lo tiene.
+  */
+  const vector<Tenencia>& ciudades(int id_producto, Grupo g) const;
+
+  /** @brief Consultora del excedente de un producto.
+      \pre <em>cierto</em>
+      \post Devuelve la suma de tiene - necesita de las ciudades a las que les sobra el producto.
+  */
+  long long excedente(int id_producto) const;
+
+  /** @brief Consultora del déficit de un producto.
+      \pre <em>cierto</em>
+      \post Devuelve la suma de necesita - tiene de las ciudades a las que les falta el producto.
+  */
+  long long deficit(int id_producto) const;
+
+  /** @brief Consultora del excedente de todos los productos.
+      \pre <em>cierto</em>
+      \post Devuelve la suma de excedente() de todos los productos.
+  */
+  long long excedente_total() const { return _excedente_total; }
+
+  /** @brief Consultora del déficit de todos los productos.
+      \pre <em>cierto</em>
+      \post Devuelve la suma de deficit() de todos los productos.
+  */
+  long long deficit_total() const { return _deficit_total; }
+};
+
+#endif
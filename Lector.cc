@@ -0,0 +1,221 @@
+/** @file Lector.cc
+    @brief Código de la clase Lector.
+*/
+
+#include "Lector.hh"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <climits>
+#include <algorithm>
+
+// Tamaño inicial del búfer: suficiente para amortizar las llamadas a read().
+static const size_t TAM_BUFER = 1 << 20;
+
+// Pre: cierto.
+// Post: Devuelve cierto si c es un separador de palabras.
+
+static inline bool es_blanco(char c) {
+    return c == ' ' or (c >= '\t' and c <= '\r');
+}
+
+// Constructora
+
+// Pre: cierto.
+// Post: El resultado es un lector situado al principio del canal estándar de entrada.
+
+Lector::Lector() : _buf(TAM_BUFER), _pos(0), _fin(0), _fd(0), _proyectado(0), _marca(SIN_MARCA),
+                   _antes_de_esperar(nullptr), _dato(nullptr) {
+    _datos = _buf.data();
+}
+
+// Pre: datos apunta a n caracteres que no se liberan mientras exista el lector.
+// Post: El resultado es un lector situado al principio de los datos.
+
+Lector::Lector(const char* datos, size_t n)
+    : _datos(datos), _pos(0), _fin(n), _fd(-1), _proyectado(0), _marca(SIN_MARCA),
+      _antes_de_esperar(nullptr), _dato(nullptr) {}
+
+// Pre: cierto.
+// Post: Se ha liberado la proyección del fichero, si la había.
+
+Lector::~Lector() {
+    if (_proyectado > 0) munmap((void*)_datos, _proyectado);
+}
+
+// Modificadoras
+
+// Pre: No se ha leído nada todavía.
+// Post: Devuelve falso si no se ha podido abrir o proyectar el fichero.
+// Si no, el lector está situado al principio del fichero.
+
+bool Lector::abrir(const char* fichero) {
+    int fd = open(fichero, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return false;
+    }
+    size_t tam = st.st_size;
+    void* p = nullptr;
+    if (tam > 0) {
+        p = mmap(nullptr, tam, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        // El guion se lee una sola vez de principio a fin.
+        madvise(p, tam, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    vector<char>().swap(_buf);
+    _datos = tam > 0 ? (const char*)p : "";
+    _proyectado = tam;
+    _pos = 0;
+    _fin = tam;
+    _fd = -1;
+    return true;
+}
+
+// Pre: cierto.
+// Post: Devuelve falso si no quedaban datos por leer. Los caracteres ya
+// consumidos se han podido descartar.
+
+bool Lector::recargar() {
+    if (_fd < 0) return false;
+    // Descartamos lo consumido; lo pendiente (o lo marcado) pasa al principio del búfer.
+    size_t desde = _marca == SIN_MARCA ? _pos : _marca;
+    if (desde > 0) {
+        memmove(_buf.data(), _datos + desde, _fin - desde);
+        _fin -= desde;
+        _pos -= desde;
+        if (_marca != SIN_MARCA) _marca = 0;
+    }
+    // Una palabra más larga que el búfer: lo ampliamos.
+    if (_fin == _buf.size()) _buf.resize(2 * _buf.size());
+    _datos = _buf.data();
+
+    if (_antes_de_esperar != nullptr) _antes_de_esperar(_dato);
+    ssize_t n;
+    do {
+        n = read(_fd, _buf.data() + _fin, _buf.size() - _fin);
+    } while (n < 0 and errno == EINTR);
+    if (n <= 0) {
+        _fd = -1;
+        return false;
+    }
+    _fin += n;
+    return true;
+}
+
+// Pre: cierto.
+// Post: Devuelve falso si se ha llegado al final de la entrada.
+
+bool Lector::saltar_blancos() {
+    while (true) {
+        while (_pos < _fin and es_blanco(_datos[_pos])) ++_pos;
+        if (_pos < _fin) return true;
+        if (not recargar()) return false;
+    }
+}
+
+// Pre: cierto.
+// Post: Antes de cada lectura del descriptor, que puede bloquear al
+// programa, se llamará a f(dato).
+
+void Lector::antes_de_esperar(void (*f)(void*), void* dato) {
+    _antes_de_esperar = f;
+    _dato = dato;
+}
+
+// Pre: cierto.
+// Post: desde_marca() devolverá el texto consumido a partir de ahora.
+
+void Lector::marcar() {
+    _marca = _pos;
+}
+
+// Pre: Se ha llamado a marcar().
+// Post: Devuelve una vista del texto consumido desde la marca, válida
+// hasta la siguiente lectura. La marca desaparece.
+
+Token Lector::desde_marca() {
+    Token t;
+    t.p = _datos + _marca;
+    t.n = _pos - _marca;
+    _marca = SIN_MARCA;
+    return t;
+}
+
+// Lectura
+
+// Pre: cierto.
+// Post: Devuelve falso si no quedan palabras. Si no, t apunta a la palabra
+// leída, válida hasta la siguiente operación de lectura.
+
+bool Lector::leer_token(Token& t) {
+    if (not saltar_blancos()) return false;
+    // La palabra empieza en _pos; contamos relativo a _pos porque recargar
+    // puede desplazar el contenido del búfer.
+    size_t n = 0;
+    while (true) {
+        while (_pos + n < _fin and not es_blanco(_datos[_pos + n])) ++n;
+        if (_pos + n < _fin or not recargar()) break;
+    }
+    t.p = _datos + _pos;
+    t.n = n;
+    _pos += n;
+    return true;
+}
+
+// Pre: En la entrada se encuentra un entero.
+// Post: Devuelve el entero leído, o 0 si no quedaba entrada. Si no cabe en
+// un int, devuelve el mayor o el menor int, como la extracción con cin.
+
+int Lector::leer_entero() {
+    Token t;
+    if (not leer_token(t)) return 0;
+    int i = 0;
+    bool negativo = false;
+    if (i < t.n and (t.p[i] == '-' or t.p[i] == '+')) {
+        negativo = t.p[i] == '-';
+        ++i;
+    }
+    // En long long y sin pasar de INT_MAX + 1, que es el valor absoluto del menor int.
+    const long long limite = (long long)INT_MAX + 1;
+    long long x = 0;
+    while (i < t.n and t.p[i] >= '0' and t.p[i] <= '9') {
+        x = min(limite, 10 * x + (t.p[i] - '0'));
+        ++i;
+    }
+    if (negativo) return int(-x);
+    return int(min(x, (long long)INT_MAX));
+}
+
+// Pre: cierto.
+// Post: Devuelve la palabra leída, o el string vacío si no quedaba entrada.
+
+string Lector::leer_string() {
+    Token t;
+    if (not leer_token(t)) return string();
+    return t.str();
+}
+
+// Pre: cierto.
+// Post: La siguiente lectura empieza en la línea siguiente.
+
+void Lector::saltar_linea() {
+    while (true) {
+        while (_pos < _fin and _datos[_pos] != '\n') ++_pos;
+        if (_pos < _fin) {
+            ++_pos;
+            return;
+        }
+        if (not recargar()) return;
+    }
+}
@@ -0,0 +1,172 @@
+/** @file Lector.hh
+    @brief Especificación de la clase Lector.
+*/
+
+#ifndef _LECTOR_HH_
+#define _LECTOR_HH_
+
+#ifndef NO_DIAGRAM
+#include <string>
+#include <vector>
+#include <cstring>
+#endif
+
+using namespace std;
+
+/** @brief Vista sobre una palabra del búfer de entrada.
+
+    No es propietaria de los caracteres: solo es válida mientras el Lector
+    no descarte la zona del búfer donde se encuentra.
+*/
+struct Token {
+  /** @brief Primer carácter de la palabra. */
+  const char* p;
+  /** @brief Longitud de la palabra. */
+  int n;
+
+  /** @brief Compara la palabra con una cadena terminada en '\\0'. */
+  bool es(const char* s) const {
+    return int(strlen(s)) == n and memcmp(p, s, n) == 0;
+  }
+
+  /** @brief Copia la palabra en un string. */
+  string str() const {
+    return string(p, n);
+  }
+};
+
+/** @class Lector
+    @brief Lector de palabras y enteros sobre un búfer grande de entrada.
+
+    Sustituye a la extracción con <em>cin</em>: lee el canal estándar de entrada
+    por bloques grandes y entrega las palabras como vistas (Token) sobre el
+    propio búfer, sin crear un string por palabra. Los enteros se convierten
+    directamente desde los caracteres del búfer.
+
+    También puede leer de un fichero proyectado en memoria o de una zona de
+    memoria: entonces el búfer son los propios datos y no se copia ni se
+    recarga nada.
+
+    Con marcar() se puede recuperar después el texto consumido desde la marca,
+    por ejemplo los argumentos de un comando.
+*/
+
+class Lector
+{
+
+private:
+  /** @brief Búfer con los caracteres leídos y aún no descartados. */
+  vector<char> _buf;
+  /** @brief Principio de los datos: el búfer o el fichero proyectado. */
+  const char* _datos;
+  /** @brief Posición del siguiente carácter por consumir. */
+  size_t _pos;
+  /** @brief Número de caracteres válidos en los datos. */
+  size_t _fin;
+  /** @brief Descriptor del que se recarga el búfer, -1 si no hay más datos. */
+  int _fd;
+  /** @brief Tamaño de la proyección del fichero, 0 si no hay. */
+  size_t _proyectado;
+  /** @brief Posición marcada, o SIN_MARCA. Lo que hay desde ella no se descarta. */
+  size_t _marca;
+  /** @brief Función a la que se llama antes de esperar datos, o nula. */
+  void (*_antes_de_esperar)(void*);
+  /** @brief Argumento de _antes_de_esperar. */
+  void* _dato;
+
+  /** @brief Valor de _marca cuando no hay marca. */
+  static const size_t SIN_MARCA = size_t(-1);
+
+  /** @brief Lee más datos del descriptor al final del búfer.
+      \pre <em>cierto</em>
+      \post Devuelve falso si no quedaban datos por leer. Los caracteres ya
+      consumidos se han podido descartar.
+  */
+  bool recargar();
+
+  /** @brief Salta los separadores.
+      \pre <em>cierto</em>
+      \post Devuelve falso si se ha llegado al final de la entrada.
+  */
+  bool saltar_blancos();
+
+public:
+  // Constructora
+
+  /** @brief Creadora sobre el canal estándar de entrada.
+      \pre <em>cierto</em>
+      \post El resultado es un lector situado al principio del canal estándar de entrada.
+  */
+  Lector();
+
+  /** @brief Creadora sobre una zona de memoria.
+      \pre datos apunta a n caracteres que no se liberan mientras exista el lector.
+      \post El resultado es un lector situado al principio de los datos.
+  */
+  Lector(const char* datos, size_t n);
+
+  /** @brief Destructora.
+      \pre <em>cierto</em>
+      \post Se ha liberado la proyección del fichero, si la había.
+  */
+  ~Lector();
+
+  // Modificadoras
+
+  /** @brief Pasa a leer de un fichero proyectado en memoria.
+      \pre No se ha leído nada todavía.
+      \post Devuelve falso si no se ha podido abrir o proyectar el fichero.
+      Si no, el lector está situado al principio del fichero.
+  */
+  bool abrir(const char* fichero);
+
+  /** @brief Registra una función a la que llamar antes de esperar datos.
+      \pre <em>cierto</em>
+      \post Antes de cada lectura del descriptor, que puede bloquear al
+      programa, se llamará a f(dato).
+  */
+  void antes_de_esperar(void (*f)(void*), void* dato);
+
+  /** @brief Marca la posición actual.
+      \pre <em>cierto</em>
+      \post desde_marca() devolverá el texto consumido a partir de ahora.
+  */
+  void marcar();
+
+  /** @brief Texto consumido desde la marca.
+      \pre Se ha llamado a marcar().
+      \post Devuelve una vista del texto consumido desde la marca, válida
+      hasta la siguiente lectura. La marca desaparece.
+  */
+  Token desde_marca();
+
+  // Lectura
+
+  /** @brief Lee la siguiente palabra.
+      \pre <em>cierto</em>
+      \post Devuelve falso si no quedan palabras. Si no, t apunta a la palabra
+      leída, válida hasta la siguiente operación de lectura.
+  */
+  bool leer_token(Token& t);
+
+  /** @brief Lee un entero con signo.
+      \pre En la entrada se encuentra un entero.
+      \post Devuelve el entero leído, o 0 si no quedaba entrada. Si no cabe
+      en un int, devuelve el mayor o el menor int.
+  */
+  int leer_entero();
+
+  /** @brief Lee una palabra como string.
+      \pre <em>cierto</em>
+      \post Devuelve la palabra leída, o el string vacío si no quedaba entrada.
+  */
+  string leer_string();
+
+  /** @brief Descarta el resto de la línea actual.
+      \pre <em>cierto</em>
+      \post La siguiente lectura empieza en la línea siguiente.
+  */
+  void saltar_linea();
+};
+
+#endif
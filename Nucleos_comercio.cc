@@ -0,0 +1,310 @@
+/** @file Nucleos_comercio.cc
+    @brief Código de los núcleos vectoriales de comerciar.
+
+    Los bloques de IDs iguales se resuelven con SSE4.2 o AVX2, o producto a
+    producto si el procesador no admite ninguno. La primera vez que se usan se
+    consulta qué admite el procesador y se elige la mejor opción; el resultado
+    es el mismo con cualquiera de ellas.
+*/
+
+#include "Nucleos_comercio.hh"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NUCLEOS_X86
+#include <immintrin.h>
+#endif
+
+// Máximo de coincidencias que se mezclan sin probar un bloque tras fallar.
+static const int MAX_ESPERA = 64;
+
+// A un inventario denso le falta menos de un ID de cada DISPERSION de su rango.
+static const int DISPERSION = 16;
+
+/** @brief Versión de intercambios() para un juego de instrucciones. */
+typedef int (*Mezcla)(const Vista_inventario& a, const Vista_inventario& b,
+                      int* pos_a, int* pos_b, int* balance);
+
+// Pre: cierto.
+// Post: Devuelve el balance de dos excedentes, como en intercambios().
+
+static inline int balance_de(int excedente1, int excedente2) {
+    int balance = 0;
+    if (excedente1 > 0 and excedente2 < 0) balance = excedente1 < -excedente2 ? excedente1 : -excedente2;
+    else if (excedente1 < 0 and excedente2 > 0) balance = -(-excedente1 < excedente2 ? -excedente1 : excedente2);
+    return balance;
+}
+
+// Mezcla por tramos: se mezcla producto a producto hasta una coincidencia en
+// la que toca probar un bloque, se prueba y se sigue. La mezcla escalar se
+// integra así en cada versión vectorial sin llamadas en el bucle. Si un bloque
+// no sale, no se vuelve a probar hasta pasadas tantas coincidencias como
+// fallos seguidos ha habido, hasta MAX_ESPERA: con inventarios poco parecidos
+// casi no se prueban.
+
+// Pre: Las de intercambios(); hay k intercambios anotados; un bloque acaba
+// ultimo posiciones después de donde empieza, y puede empezar en posiciones
+// menores que fin1 y fin2.
+// Post: Se han anotado los intercambios desde i y j hasta acabar uno de los
+// inventarios o hasta una coincidencia en i y j con espera == 0 en la que cabe
+// un bloque que también acaba con el mismo ID, y se devuelve el nuevo total.
+
+static inline int mezclar(const Vista_inventario& a, const Vista_inventario& b, int& i, int& j,
+                          int& espera, int ultimo, int fin1, int fin2,
+                          int* pos_a, int* pos_b, int* balance, int k) {
+    // Copias locales: las escrituras en los resultados podrían solaparse con
+    // las vistas y obligarían a releerlas en cada paso.
+    const int* ids1 = a.ids;
+    const int* ids2 = b.ids;
+    const int* tiene1 = a.tiene;
+    const int* tiene2 = b.tiene;
+    const int* necesita1 = a.necesita;
+    const int* necesita2 = b.necesita;
+    int n1 = a.n;
+    int n2 = b.n;
+    while (i < n1 and j < n2) {
+        int id1 = ids1[i];
+        int id2 = ids2[j];
+        if (id1 == id2) {
+            if (espera == 0 and i < fin1 and j < fin2 and ids1[i + ultimo] == ids2[j + ultimo]) return k;
+            if (espera > 0) --espera;
+            int bal = balance_de(tiene1[i] - necesita1[i], tiene2[j] - necesita2[j]);
+            if (bal != 0) {
+                pos_a[k] = i;
+                pos_b[k] = j;
+                balance[k] = bal;
+                ++k;
+            }
+            ++i;
+            ++j;
+        }
+        else if (id1 < id2) ++i;
+        else ++j;
+    }
+    return k;
+}
+
+// Pre: fallos es el número de bloques seguidos que no han salido, contando el
+// último.
+// Post: Devuelve cuántas coincidencias mezclar antes de probar otro bloque.
+
+static inline int espera_tras(int fallos) {
+    return fallos < MAX_ESPERA ? fallos : MAX_ESPERA;
+}
+
+// Pre: Las de intercambios().
+// Post: Las de intercambios(), producto a producto.
+
+static int mezcla_escalar(const Vista_inventario& a, const Vista_inventario& b,
+                          int* pos_a, int* pos_b, int* balance) {
+    int i = 0;
+    int j = 0;
+    int espera = 0;
+    return mezclar(a, b, i, j, espera, 0, 0, 0, pos_a, pos_b, balance, 0);
+}
+
+#ifdef NUCLEOS_X86
+
+// Compactación: para cada máscara de carriles, la permutación que lleva los
+// carriles marcados al principio, en orden. Se rellenan en elegir_mezcla().
+// Los núcleos escriben todos los carriles y solo cuentan los compactados; los
+// demás se sobrescriben después o caen en el margen de HOLGURA.
+static int compactar8[256][8];
+static unsigned char compactar4[16][16];
+
+// Pre: cierto.
+// Post: compactar8 y compactar4 tienen las permutaciones de cada máscara.
+
+static void preparar_compactacion() {
+    for (int m = 0; m < 256; ++m) {
+        int k = 0;
+        for (int b = 0; b < 8; ++b) {
+            if (m & (1 << b)) compactar8[m][k++] = b;
+        }
+        while (k < 8) compactar8[m][k++] = 0;
+    }
+    for (int m = 0; m < 16; ++m) {
+        int k = 0;
+        for (int b = 0; b < 4; ++b) {
+            if (m & (1 << b)) {
+                for (int c = 0; c < 4; ++c) compactar4[m][4*k + c] = (unsigned char)(4*b + c);
+                ++k;
+            }
+        }
+        for (int c = 4*k; c < 16; ++c) compactar4[m][c] = 0x80;
+    }
+}
+
+// En un bloque con los mismos IDs, con da = min(e1, -e2) y recibe =
+// min(-e1, e2), el balance es max(da, 0) - max(recibe, 0): da solo es positivo
+// si a la primera le sobra y a la segunda le falta, y recibe en el caso
+// contrario. Se guardan compactados los que no son 0.
+
+// Pre: a y b tienen al menos 4 productos a partir de i y j; hay k
+// intercambios anotados.
+// Post: Si a.ids[i..i+4) == b.ids[j..j+4), se han anotado sus intercambios y se
+// devuelve el nuevo total; si no, se devuelve -1.
+
+__attribute__((target("sse4.2")))
+static inline int bloque_sse(const Vista_inventario& a, const Vista_inventario& b, int i, int j,
+                             int* pos_a, int* pos_b, int* balance, int k) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(a.ids + i));
+    __m128i y = _mm_loadu_si128((const __m128i*)(b.ids + j));
+    if (_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, y))) != 0xf) return -1;
+
+    const __m128i cero = _mm_setzero_si128();
+    __m128i e1 = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(a.tiene + i)),
+                               _mm_loadu_si128((const __m128i*)(a.necesita + i)));
+    __m128i e2 = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(b.tiene + j)),
+                               _mm_loadu_si128((const __m128i*)(b.necesita + j)));
+    __m128i da = _mm_min_epi32(e1, _mm_sub_epi32(cero, e2));
+    __m128i recibe = _mm_min_epi32(_mm_sub_epi32(cero, e1), e2);
+    __m128i bal = _mm_sub_epi32(_mm_max_epi32(da, cero), _mm_max_epi32(recibe, cero));
+    unsigned marca = ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(bal, cero))) & 0xf;
+    if (marca != 0) {
+        const __m128i iota = _mm_setr_epi32(0, 1, 2, 3);
+        __m128i orden = _mm_loadu_si128((const __m128i*)compactar4[marca]);
+        __m128i pi = _mm_add_epi32(_mm_set1_epi32(i), iota);
+        __m128i pj = _mm_add_epi32(_mm_set1_epi32(j), iota);
+        _mm_storeu_si128((__m128i*)(pos_a + k), _mm_shuffle_epi8(pi, orden));
+        _mm_storeu_si128((__m128i*)(pos_b + k), _mm_shuffle_epi8(pj, orden));
+        _mm_storeu_si128((__m128i*)(balance + k), _mm_shuffle_epi8(bal, orden));
+        k += __builtin_popcount(marca);
+    }
+    return k;
+}
+
+// Pre: a y b tienen al menos 8 productos a partir de i y j; hay k
+// intercambios anotados.
+// Post: Si a.ids[i..i+8) == b.ids[j..j+8), se han anotado sus intercambios y se
+// devuelve el nuevo total; si no, se devuelve -1.
+
+__attribute__((target("avx2")))
+static inline int bloque_avx2(const Vista_inventario& a, const Vista_inventario& b, int i, int j,
+                              int* pos_a, int* pos_b, int* balance, int k) {
+    __m256i x = _mm256_loadu_si256((const __m256i*)(a.ids + i));
+    __m256i y = _mm256_loadu_si256((const __m256i*)(b.ids + j));
+    if (_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, y))) != 0xff) return -1;
+
+    const __m256i cero = _mm256_setzero_si256();
+    __m256i e1 = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(a.tiene + i)),
+                                  _mm256_loadu_si256((const __m256i*)(a.necesita + i)));
+    __m256i e2 = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(b.tiene + j)),
+                                  _mm256_loadu_si256((const __m256i*)(b.necesita + j)));
+    __m256i da = _mm256_min_epi32(e1, _mm256_sub_epi32(cero, e2));
+    __m256i recibe = _mm256_min_epi32(_mm256_sub_epi32(cero, e1), e2);
+    __m256i bal = _mm256_sub_epi32(_mm256_max_epi32(da, cero), _mm256_max_epi32(recibe, cero));
+    unsigned marca = ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(bal, cero))) & 0xff;
+    if (marca != 0) {
+        const __m256i iota = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i orden = _mm256_loadu_si256((const __m256i*)compactar8[marca]);
+        __m256i pi = _mm256_add_epi32(_mm256_set1_epi32(i), iota);
+        __m256i pj = _mm256_add_epi32(_mm256_set1_epi32(j), iota);
+        _mm256_storeu_si256((__m256i*)(pos_a + k), _mm256_permutevar8x32_epi32(pi, orden));
+        _mm256_storeu_si256((__m256i*)(pos_b + k), _mm256_permutevar8x32_epi32(pj, orden));
+        _mm256_storeu_si256((__m256i*)(balance + k), _mm256_permutevar8x32_epi32(bal, orden));
+        k += __builtin_popcount(marca);
+    }
+    return k;
+}
+
+// Pre: Las de intercambios().
+// Post: Las de intercambios(), con bloques de 4 productos.
+
+__attribute__((target("sse4.2")))
+static int mezcla_sse(const Vista_inventario& a, const Vista_inventario& b,
+                      int* pos_a, int* pos_b, int* balance) {
+    int i = 0;
+    int j = 0;
+    int k = 0;
+    int espera = 0;
+    int fallos = 0;
+    while (true) {
+        k = mezclar(a, b, i, j, espera, 3, a.n - 3, b.n - 3, pos_a, pos_b, balance, k);
+        if (i >= a.n or j >= b.n) return k;
+        int r = bloque_sse(a, b, i, j, pos_a, pos_b, balance, k);
+        if (r >= 0) {
+            k = r;
+            i += 4;
+            j += 4;
+            fallos = 0;
+        }
+        else espera = espera_tras(++fallos);
+    }
+}
+
+// Pre: Las de intercambios().
+// Post: Las de intercambios(), con bloques de 8 productos.
+
+__attribute__((target("avx2")))
+static int mezcla_avx2(const Vista_inventario& a, const Vista_inventario& b,
+                       int* pos_a, int* pos_b, int* balance) {
+    int i = 0;
+    int j = 0;
+    int k = 0;
+    int espera = 0;
+    int fallos = 0;
+    while (true) {
+        k = mezclar(a, b, i, j, espera, 7, a.n - 7, b.n - 7, pos_a, pos_b, balance, k);
+        if (i >= a.n or j >= b.n) return k;
+        int r = bloque_avx2(a, b, i, j, pos_a, pos_b, balance, k);
+        if (r >= 0) {
+            k = r;
+            i += 8;
+            j += 8;
+            fallos = 0;
+        }
+        else espera = espera_tras(++fallos);
+    }
+}
+
+#endif
+
+// Pre: cierto.
+// Post: Devuelve la mejor versión de intercambios() que admite el procesador.
+
+static Mezcla elegir_mezcla() {
+    Mezcla m = mezcla_escalar;
+#ifdef NUCLEOS_X86
+    __builtin_cpu_init();
+    preparar_compactacion();
+    if (__builtin_cpu_supports("avx2")) m = mezcla_avx2;
+    else if (__builtin_cpu_supports("sse4.2")) m = mezcla_sse;
+#endif
+    return m;
+}
+
+// Pre: cierto.
+// Post: Devuelve la versión de intercambios() elegida, eligiéndola la primera vez.
+
+static Mezcla mezcla_elegida() {
+    static const Mezcla m = elegir_mezcla();
+    return m;
+}
+
+// Pre: cierto.
+// Post: Devuelve si al inventario le falta menos de un ID de cada DISPERSION
+// entre el primero y el último.
+
+static bool denso(const Vista_inventario& a) {
+    if (a.n == 0) return false;
+    long long rango = (long long)a.ids[a.n - 1] - a.ids[0] + 1;
+    return (rango - a.n) * DISPERSION < rango;
+}
+
+// Pre: cierto.
+// Post: Devuelve si hay núcleos de bloques y los dos inventarios son densos.
+
+bool por_bloques(const Vista_inventario& a, const Vista_inventario& b) {
+    return mezcla_elegida() != mezcla_escalar and denso(a) and denso(b);
+}
+
+// Pre: pos_a, pos_b y balance tienen espacio para min(a.n, b.n) + HOLGURA
+// enteros.
+// Post: Devuelve el número k de productos comunes con intercambio y, para cada
+// t < k en orden creciente, sus posiciones en a y b y lo que a da (> 0) o
+// recibe (< 0).
+
+int intercambios(const Vista_inventario& a, const Vista_inventario& b,
+                 int* pos_a, int* pos_b, int* balance) {
+    return mezcla_elegida()(a, b, pos_a, pos_b, balance);
+}
@@ -0,0 +1,52 @@
+/** @file Nucleos_comercio.hh
+    @brief Especificación de los núcleos vectoriales de comerciar.
+*/
+
+#ifndef _NUCLEOS_COMERCIO_HH_
+#define _NUCLEOS_COMERCIO_HH_
+
+/** @brief Enteros de más que necesitan los vectores de resultado de intercambios(). */
+const int HOLGURA = 8;
+
+/** @brief Inventario de una ciudad en vectores paralelos.
+
+    Los IDs están en orden estrictamente creciente y son no negativos; tiene y
+    necesita dan las unidades de cada posición.
+*/
+struct Vista_inventario {
+  /** @brief IDs de los productos. */
+  const int* ids;
+  /** @brief Unidades que tiene de cada producto. */
+  const int* tiene;
+  /** @brief Unidades que necesita de cada producto. */
+  const int* necesita;
+  /** @brief Número de productos. */
+  int n;
+};
+
+/** @brief Intercambios de comerciar entre dos inventarios.
+    \pre pos_a, pos_b y balance tienen espacio para min(a.n, b.n) + HOLGURA
+    enteros.
+    \post Devuelve el número k de productos comunes con intercambio y, para cada
+    0 <= t < k en orden creciente, a.ids[pos_a[t]] == b.ids[pos_b[t]] y
+    balance[t] != 0 es lo que a da (> 0) o recibe (< 0) de ese producto: con e1
+    y e2 los excedentes (tiene - necesita), min(e1, -e2) si e1 > 0 y e2 < 0, y
+    -min(-e1, e2) si e1 < 0 y e2 > 0.
+
+    Se mezclan los dos inventarios y, cuando un bloque de IDs es igual en los
+    dos, se resuelve entero a la vez en los carriles de un registro vectorial.
+    Los resultados de cada bloque se escriben todos de una vez, por eso hace
+    falta la holgura.
+*/
+int intercambios(const Vista_inventario& a, const Vista_inventario& b,
+                 int* pos_a, int* pos_b, int* balance);
+
+/** @brief Consulta si intercambios() compensa frente a una mezcla escalar.
+    \pre cierto.
+    \post Devuelve cierto si el procesador tiene núcleos de bloques y a los dos
+    inventarios les falta menos de un ID de cada 16 entre el primero y el
+    último, es decir, si se espera que casi todos los bloques coincidan.
+*/
+bool por_bloques(const Vista_inventario& a, const Vista_inventario& b);
+
+#endif
@@ -0,0 +1,116 @@
+/** @file Pool_hilos.cc
+    @brief Código de la clase Pool_hilos.
+*/
+
+#include "Pool_hilos.hh"
+
+// Pool al que pertenece el hilo actual y su número dentro de él.
+static thread_local const Pool_hilos* pool_actual = nullptr;
+static thread_local int indice_actual = 0;
+
+// Pre: cierto.
+// Post: Devuelve el número del hilo que llama, o 0 si no es un hilo de trabajo del pool.
+
+int Pool_hilos::hilo_actual() const {
+    return pool_actual == this ? indice_actual : 0;
+}
+
+// Pre: 0 <= yo < num_hilos().
+// Post: Si había alguna tarea, se ha ejecutado una (de la cola propia o
+// robada de otra) y devuelve cierto; si no, devuelve falso.
+
+bool Pool_hilos::ejecutar_una(int yo) {
+    if (_en_cola.load() == 0) return false;
+    int n = _colas.size();
+    Tarea t;
+    bool hay = false;
+    // Primero la propia cola por el final: es la tarea más reciente y la de
+    // datos más cercanos; después se roba por el principio de las demás, que
+    // son las tareas más antiguas y, en fork-join, las más grandes.
+    for (int k = 0; k < n and not hay; ++k) {
+        Cola& c = *_colas[(yo + k) % n];
+        lock_guard<mutex> l(c.m);
+        if (not c.tareas.empty()) {
+            if (k == 0) {
+                t = move(c.tareas.back());
+                c.tareas.pop_back();
+            } else {
+                t = move(c.tareas.front());
+                c.tareas.pop_front();
+            }
+            hay = true;
+        }
+    }
+    if (not hay) return false;
+    --_en_cola;
+    t.f();
+    --t.g->_pendientes;
+    return true;
+}
+
+// Pre: 1 <= yo < num_hilos().
+// Post: Se han ejecutado tareas hasta que el pool ha terminado.
+
+void Pool_hilos::trabajar(int yo) {
+    pool_actual = this;
+    indice_actual = yo;
+    while (true) {
+        if (ejecutar_una(yo)) continue;
+        unique_lock<mutex> l(_m);
+        _cv.wait(l, [this] { return _fin or _en_cola.load() > 0; });
+        if (_fin) return;
+    }
+}
+
+// Constructora
+
+// Pre: num_hilos >= 1.
+// Post: El pool tiene num_hilos hilos contando el que lo crea, que es el 0.
+
+Pool_hilos::Pool_hilos(int num_hilos) : _en_cola(0), _fin(false) {
+    for (int i = 0; i < num_hilos; ++i) _colas.push_back(unique_ptr<Cola>(new Cola()));
+    for (int i = 1; i < num_hilos; ++i) _hilos.push_back(thread(&Pool_hilos::trabajar, this, i));
+}
+
+// Pre: No quedan tareas pendientes.
+// Post: Los hilos de trabajo han terminado.
+
+Pool_hilos::~Pool_hilos() {
+    {
+        lock_guard<mutex> l(_m);
+        _fin = true;
+    }
+    _cv.notify_all();
+    for (int i = 0; i < int(_hilos.size()); ++i) _hilos[i].join();
+}
+
+// Modificadoras
+
+// Pre: cierto.
+// Post: f se ejecutará en algún hilo del pool como parte del grupo g.
+
+void Pool_hilos::lanzar(Grupo& g, function<void()> f) {
+    ++g._pendientes;
+    Cola& c = *_colas[hilo_actual()];
+    {
+        lock_guard<mutex> l(c.m);
+        c.tareas.push_back(Tarea{ move(f), &g });
+    }
+    ++_en_cola;
+    // Se toma _m para que ningún hilo se quede dormido justo después de ver la cola vacía.
+    {
+        lock_guard<mutex> l(_m);
+    }
+    _cv.notify_one();
+}
+
+// Pre: cierto.
+// Post: Todas las tareas lanzadas en g han terminado. Mientras tanto, el hilo
+// que espera ha ayudado a ejecutar tareas.
+
+void Pool_hilos::esperar(Grupo& g) {
+    int yo = hilo_actual();
+    while (g._pendientes.load() > 0) {
+        if (not ejecutar_una(yo)) this_thread::yield();
+    }
+}
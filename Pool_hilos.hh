@@ -0,0 +1,133 @@
+/** @file Pool_hilos.hh
+    @brief Especificación de la clase Pool_hilos.
+*/
+
+#ifndef _POOL_HILOS_HH_
+#define _POOL_HILOS_HH_
+
+#ifndef NO_DIAGRAM
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#endif
+
+using namespace std;
+
+/** @class Pool_hilos
+    @brief Conjunto fijo de hilos para ejecutar tareas de tipo fork-join.
+
+    Cada hilo tiene su propia cola de tareas: las que lanza las pone al final y
+    las ejecuta empezando también por el final, mientras que un hilo sin trabajo
+    roba del principio de la cola de otro (work stealing). El hilo que crea el
+    pool cuenta como uno de ellos, el número 0.
+
+    Las tareas se agrupan: esperar(g) no vuelve hasta que han terminado todas
+    las tareas lanzadas en g, y mientras tanto el hilo que espera ejecuta otras
+    tareas, de modo que una tarea puede lanzar y esperar subtareas sin bloquear
+    el pool.
+*/
+
+class Pool_hilos
+{
+
+public:
+  /** @brief Grupo de tareas que se esperan juntas. */
+  class Grupo {
+    friend class Pool_hilos;
+    /** @brief Tareas lanzadas y aún no terminadas. */
+    atomic<int> _pendientes;
+  public:
+    /** @brief Creadora: el grupo no tiene tareas pendientes. */
+    Grupo() : _pendientes(0) {}
+  };
+
+private:
+  /** @brief Tarea por ejecutar y grupo al que pertenece. */
+  struct Tarea {
+    function<void()> f;
+    Grupo* g;
+  };
+  /** @brief Cola de tareas de un hilo. */
+  struct Cola {
+    mutex m;
+    deque<Tarea> tareas;
+  };
+  /** @brief Cola de cada hilo; la 0 es la del hilo que ha creado el pool. */
+  vector<unique_ptr<Cola> > _colas;
+  /** @brief Hilos de trabajo (1, 2, ...). */
+  vector<thread> _hilos;
+  /** @brief Número total de tareas en las colas. */
+  atomic<int> _en_cola;
+  /** @brief Protege _fin y la espera de los hilos sin trabajo. */
+  mutex _m;
+  /** @brief Avisa a los hilos sin trabajo de que hay tareas nuevas. */
+  condition_variable _cv;
+  /** @brief Cierto cuando los hilos deben terminar. */
+  bool _fin;
+
+  /** @brief Índice del hilo actual en el pool.
+      \pre <em>cierto</em>
+      \post Devuelve el número del hilo que llama, o 0 si no es un hilo de trabajo del pool.
+  */
+  int hilo_actual() const;
+
+  /** @brief Ejecuta una tarea pendiente.
+      \pre 0 <= yo < num_hilos().
+      \post Si había alguna tarea, se ha ejecutado una (de la cola propia o
+      robada de otra) y devuelve cierto; si no, devuelve falso.
+  */
+  bool ejecutar_una(int yo);
+
+  /** @brief Bucle de un hilo de trabajo.
+      \pre 1 <= yo < num_hilos().
+      \post Se han ejecutado tareas hasta que el pool ha terminado.
+  */
+  void trabajar(int yo);
+
+public:
+  // Constructora
+
+  /** @brief Creadora con un número de hilos.
+      \pre num_hilos >= 1.
+      \post El pool tiene num_hilos hilos contando el que lo crea, que es el 0.
+  */
+  explicit Pool_hilos(int num_hilos);
+
+  /** @brief Destructora.
+      \pre No quedan tareas pendientes.
+      \post Los hilos de trabajo han terminado.
+  */
+  ~Pool_hilos();
+
+  // Modificadoras
+
+  /** @brief Lanza una tarea.
+      \pre <em>cierto</em>
+      \post f se ejecutará en algún hilo del pool como parte del grupo g.
+  */
+  void lanzar(Grupo& g, function<void()> f);
+
+  /** @brief Espera a que terminen las tareas de un grupo.
+      \pre <em>cierto</em>
+      \post Todas las tareas lanzadas en g han terminado. Mientras tanto, el hilo
+      que espera ha ayudado a ejecutar tareas.
+  */
+  void esperar(Grupo& g);
+
+  // Consultoras
+
+  /** @brief Consultora del número de hilos.
+      \pre <em>cierto</em>
+      \post Devuelve el número de hilos del pool, contando el que lo creó.
+  */
+  int num_hilos() const {
+    return _colas.size();
+  }
+};
+
+#endif
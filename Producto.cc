@@ -31,19 +31,34 @@ int Producto::consultar_volumen() const {
 // en el canal estándar de salida.
 
 void Producto::escribir_producto() const {
-    cout << _peso << ' ' << _volumen << endl;
+    salida << _peso << ' ' << _volumen << '\n';
 }
 
 // Lectura
 
-// Pre: En el canal estándar de entrada se encuentran dos enteros no negativos 
+// Pre: En el lector in se encuentran dos enteros no negativos 
 // que representan el peso y el volumen que se van a leer. 
 // Post Se han leído el peso y volumen del parámetro implícito.
 
-void Producto::leer_producto() {
-    int peso;
-    int volumen;
-    cin >> peso >> volumen;
-    _peso = peso;
-    _volumen = volumen;
-}
\ No newline at end of file
+void Producto::leer_producto(Lector& in) {
+    _peso = in.leer_entero();
+    _volumen = in.leer_entero();
+}
+
+// Estado binario
+
+// Pre: Producto inicializado.
+// Post: Se han escrito el peso y el volumen en out.
+
+void Producto::guardar(Escritor_binario& out) const {
+    out.entero(_peso);
+    out.entero(_volumen);
+}
+
+// Pre: En in se encuentra un producto escrito con guardar.
+// Post: Se han leído el peso y volumen del parámetro implícito.
+
+void Producto::cargar(Lector_binario& in) {
+    _peso = in.entero();
+    _volumen = in.entero();
+}
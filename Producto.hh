@@ -9,6 +9,10 @@
 #include <iostream>
 #endif
 
+#include "Lector.hh"
+#include "Escritor.hh"
+#include "Binario.hh"
+
 using namespace std;
 
 /** @class Producto
@@ -67,11 +71,25 @@ public:
   // Lectura
 
   /** @brief Operación de lectura.
-      \pre En el canal estándar de entrada se encuentran dos enteros no negativos 
+      \pre En el lector in se encuentran dos enteros no negativos 
       que representan el peso y el volumen que se van a leer. 
       \post Se han leído el peso y volumen del parámetro implícito.
   */
-  void leer_producto();
+  void leer_producto(Lector& in);
+
+  // Estado binario
+
+  /** @brief Guarda el producto en un estado binario.
+      \pre Producto inicializado.
+      \post Se han escrito el peso y el volumen en out.
+  */
+  void guardar(Escritor_binario& out) const;
+
+  /** @brief Carga el producto de un estado binario.
+      \pre En in se encuentra un producto escrito con guardar.
+      \post Se han leído el peso y volumen del parámetro implícito.
+  */
+  void cargar(Lector_binario& in);
 };
 
 #endif
\ No newline at end of file
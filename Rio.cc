@@ -0,0 +1,106 @@
+/** @file Rio.cc
+    @brief Código de la clase Rio.
+*/
+
+#include "Rio.hh"
+
+// Constructora
+
+// Pre: cierto.
+// Post: El resultado es un río vacío y completo.
+
+Rio::Rio() : _completo(true) {}
+
+// Modificadoras
+
+// Pre: cierto.
+// Post: El río está vacío y a la espera de su descripción en preorden.
+
+void Rio::empezar() {
+    _ciudad.clear();
+    _izq.clear();
+    _der.clear();
+    _padre.clear();
+    _tam.clear();
+    _prof.clear();
+    _cadena.clear();
+    _pendientes.clear();
+    _completo = false;
+}
+
+// Pre: El río no está completo.
+// Post: Se ha añadido un nodo con la ciudad indicada en la siguiente
+// posición libre.
+
+void Rio::nodo(int ciudad) {
+    int i = _ciudad.size();
+    int p = -1;
+    if (not _pendientes.empty()) {
+        p = _pendientes.back();
+        if (p < 0) _izq[~p] = i;
+        else _der[p] = i;
+        if (p < 0) p = ~p;
+    }
+    _ciudad.push_back(ciudad);
+    _izq.push_back(-1);
+    _der.push_back(-1);
+    _padre.push_back(p);
+    _tam.push_back(0);
+    _prof.push_back(p < 0 ? 0 : _prof[p] + 1);
+    _pendientes.push_back(~i); // Se empieza por su subárbol izquierdo.
+}
+
+// Pre: El río no está completo.
+// Post: La siguiente posición libre queda vacía; si era la última, el río
+// está completo.
+
+void Rio::vacio() {
+    // Un subárbol derecho que termina completa su nodo, y con él quizá varios
+    // antepasados; el primero que aún esperaba su subárbol izquierdo pasa al derecho.
+    while (not _pendientes.empty() and _pendientes.back() >= 0) {
+        int i = _pendientes.back();
+        _tam[i] = _ciudad.size() - i;
+        _pendientes.pop_back();
+    }
+    if (not _pendientes.empty()) _pendientes.back() = ~_pendientes.back();
+    else {
+        _completo = true;
+        preparar_cadenas();
+    }
+}
+
+// Pre: Ya se han añadido todos los nodos y sus tamaños.
+// Post: _cadena tiene la cadena pesada de cada nodo.
+
+void Rio::preparar_cadenas() {
+    int n = _ciudad.size();
+    _cadena.resize(n);
+    // El padre va antes que sus hijos: basta una pasada en preorden.
+    for (int i = 0; i < n; ++i) {
+        int p = _padre[i];
+        if (p < 0) {
+            _cadena[i] = i;
+            continue;
+        }
+        int hermano = (_izq[p] == i ? _der[p] : _izq[p]);
+        int tam_hermano = (hermano < 0 ? 0 : _tam[hermano]);
+        // A igualdad, sigue la cadena el hijo izquierdo.
+        bool pesado = _tam[i] > tam_hermano or (_tam[i] == tam_hermano and _izq[p] == i);
+        _cadena[i] = (pesado ? _cadena[p] : i);
+    }
+}
+
+// Consultoras
+
+// Pre: El río está completo; 0 <= a, b < tamano().
+// Post: Devuelve el nodo más profundo que es antecesor de a y de b.
+
+int Rio::antecesor_comun(int a, int b) const {
+    // Se sube por la cadena que empieza más abajo hasta que los dos estén en la
+    // misma; entonces el antecesor común es el menos profundo.
+    while (_cadena[a] != _cadena[b]) {
+        if (_prof[_cadena[a]] >= _prof[_cadena[b]]) a = _padre[_cadena[a]];
+        else b = _padre[_cadena[b]];
+    }
+    return (_prof[a] <= _prof[b] ? a : b);
+}
@@ -0,0 +1,181 @@
+/** @file Rio.hh
+    @brief Especificación de la clase Rio.
+*/
+
+#ifndef _RIO_HH_
+#define _RIO_HH_
+
+#ifndef NO_DIAGRAM
+#include <vector>
+#endif
+
+using namespace std;
+
+/** @class Rio
+    @brief Estructura de la cuenca guardada en vectores, en preorden.
+
+    Cada nodo del árbol es su posición en el recorrido en preorden: la
+    desembocadura es el nodo 0 y el hijo izquierdo de un nodo, si existe, es el
+    nodo siguiente. Para cada nodo se guardan la ciudad, los dos hijos, el padre y
+    el tamaño del subárbol, de modo que los recorridos no reservan memoria ni
+    crean subárboles. Un nodo que no existe se representa con -1.
+
+    Se construye de una sola pasada a partir de la descripción en preorden
+    (nodo() para cada ciudad y vacio() para cada árbol vacío), sin recursión, y
+    después no se modifica.
+
+    Para el antecesor común de dos nodos se guardan también la profundidad de
+    cada nodo y una descomposición en cadenas pesadas: cada nodo sigue la
+    cadena de su padre si es el hijo con el subárbol más grande, y empieza una
+    nueva si no. Subiendo de una cadena a otra se cambia como mucho un número
+    logarítmico de veces, así que la consulta no recorre el camino, y todo
+    ocupa dos enteros más por nodo.
+*/
+
+class Rio
+{
+
+private:
+  /** @brief Ciudad de cada nodo. */
+  vector<int> _ciudad;
+  /** @brief Hijo izquierdo de cada nodo. */
+  vector<int> _izq;
+  /** @brief Hijo derecho de cada nodo. */
+  vector<int> _der;
+  /** @brief Padre de cada nodo (-1 en la desembocadura). */
+  vector<int> _padre;
+  /** @brief Número de nodos del subárbol de cada nodo. */
+  vector<int> _tam;
+  /** @brief Profundidad de cada nodo (0 en la desembocadura). */
+  vector<int> _prof;
+  /** @brief Primer nodo de la cadena pesada de cada nodo. */
+  vector<int> _cadena;
+  /** @brief Durante la construcción, nodos con algún hijo por completar. Un
+      nodo se guarda como ~i mientras se lee su subárbol izquierdo y como i
+      mientras se lee el derecho. */
+  vector<int> _pendientes;
+  /** @brief Cierto si ya se ha leído la descripción completa. */
+  bool _completo;
+
+  /** @brief Acaba la construcción.
+      \pre Ya se han añadido todos los nodos y sus tamaños.
+      \post _cadena tiene la cadena pesada de cada nodo.
+  */
+  void preparar_cadenas();
+
+public:
+  // Constructora
+
+  /** @brief Creadora por defecto.
+      \pre <em>cierto</em>
+      \post El resultado es un río vacío y completo.
+  */
+  Rio();
+
+  // Modificadoras
+
+  /** @brief Empieza la construcción de un río nuevo.
+      \pre <em>cierto</em>
+      \post El río está vacío y a la espera de su descripción en preorden.
+  */
+  void empezar();
+
+  /** @brief Añade el siguiente nodo de la descripción en preorden.
+      \pre El río no está completo.
+      \post Se ha añadido un nodo con la ciudad indicada en la siguiente
+      posición libre.
+  */
+  void nodo(int ciudad);
+
+  /** @brief Añade el siguiente árbol vacío de la descripción en preorden.
+      \pre El río no está completo.
+      \post La siguiente posición libre queda vacía; si era la última, el río
+      está completo.
+  */
+  void vacio();
+
+  // Consultoras
+
+  /** @brief Consultora de construcción.
+      \pre <em>cierto</em>
+      \post Devuelve cierto si ya se ha leído la descripción completa.
+  */
+  bool completo() const {
+    return _completo;
+  }
+
+  /** @brief Consultora del tamaño.
+      \pre <em>cierto</em>
+      \post Devuelve el número de nodos del río.
+  */
+  int tamano() const {
+    return _ciudad.size();
+  }
+
+  /** @brief Consultora de la ciudad de un nodo.
+      \pre 0 <= i < tamano().
+      \post Devuelve la ciudad del nodo i.
+  */
+  int ciudad(int i) const {
+    return _ciudad[i];
+  }
+
+  /** @brief Consultora del hijo izquierdo.
+      \pre 0 <= i < tamano().
+      \post Devuelve el hijo izquierdo del nodo i, o -1 si no tiene.
+  */
+  int izq(int i) const {
+    return _izq[i];
+  }
+
+  /** @brief Consultora del hijo derecho.
+      \pre 0 <= i < tamano().
+      \post Devuelve el hijo derecho del nodo i, o -1 si no tiene.
+  */
+  int der(int i) const {
+    return _der[i];
+  }
+
+  /** @brief Consultora del padre.
+      \pre 0 <= i < tamano().
+      \post Devuelve el padre del nodo i, o -1 si es la desembocadura.
+  */
+  int padre(int i) const {
+    return _padre[i];
+  }
+
+  /** @brief Consultora del tamaño de un subárbol.
+      \pre 0 <= i < tamano().
+      \post Devuelve el número de nodos del subárbol de i, que son los nodos
+      i, i+1, ..., i+tam(i)-1.
+  */
+  int tam(int i) const {
+    return _tam[i];
+  }
+
+  /** @brief Consultora de la profundidad.
+      \pre 0 <= i < tamano().
+      \post Devuelve el número de nodos entre i y la desembocadura, sin contar i.
+  */
+  int profundidad(int i) const {
+    return _prof[i];
+  }
+
+  /** @brief Antecesor común más bajo.
+      \pre El río está completo; 0 <= a, b < tamano().
+      \post Devuelve el nodo más profundo que es antecesor de a y de b. Cuesta
+      un tiempo logarítmico en el tamaño del río.
+  */
+  int antecesor_comun(int a, int b) const;
+
+  /** @brief Distancia entre dos nodos.
+      \pre El río está completo; 0 <= a, b < tamano().
+      \post Devuelve el número de tramos de río entre a y b, pasando por su
+      antecesor común. Cuesta un tiempo logarítmico en el tamaño del río.
+  */
+  int distancia(int a, int b) const {
+    return _prof[a] + _prof[b] - 2 * _prof[antecesor_comun(a, b)];
+  }
+};
+
+#endif
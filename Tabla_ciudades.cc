@@ -0,0 +1,81 @@
+/** @file Tabla_ciudades.cc
+    @brief Código de la clase Tabla_ciudades.
+*/
+
+#include "Tabla_ciudades.hh"
+
+// Número de posiciones de una tabla vacía (potencia de dos).
+static const int TAM_INICIAL = 16;
+
+// Pre: cierto.
+// Post: Devuelve el hash de los n caracteres de p.
+
+unsigned int Tabla_ciudades::hash(const char* p, int n) {
+    unsigned int h = 2166136261u;
+    for (int i = 0; i < n; ++i) {
+        h ^= (unsigned char)p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Pre: La tabla tiene posiciones libres.
+// Post: Devuelve la posición que ocupa el nombre de n caracteres p o, si no
+// está, la posición libre donde iría.
+
+int Tabla_ciudades::posicion(const char* p, int n) const {
+    unsigned int mascara = _tabla.size() - 1;
+    unsigned int i = hash(p, n) & mascara;
+    while (_tabla[i] >= 0) {
+        const string& s = _nombres[_tabla[i]];
+        if (int(s.size()) == n and memcmp(s.data(), p, n) == 0) return i;
+        i = (i + 1) & mascara;
+    }
+    return i;
+}
+
+// Pre: cierto.
+// Post: La tabla tiene el doble de posiciones y los mismos nombres.
+
+void Tabla_ciudades::crecer() {
+    _tabla.assign(2 * _tabla.size(), -1);
+    unsigned int mascara = _tabla.size() - 1;
+    for (int id = 0; id < int(_nombres.size()); ++id) {
+        unsigned int i = hash(_nombres[id].data(), _nombres[id].size()) & mascara;
+        while (_tabla[i] >= 0) i = (i + 1) & mascara;
+        _tabla[i] = id;
+    }
+}
+
+// Constructora
+
+// Pre: cierto.
+// Post: El resultado es una tabla sin nombres.
+
+Tabla_ciudades::Tabla_ciudades() : _tabla(TAM_INICIAL, -1) {}
+
+// Modificadoras
+
+// Pre: cierto.
+// Post: Devuelve el identificador del nombre de n caracteres p; si no
+// estaba, se le asigna el siguiente identificador libre.
+
+int Tabla_ciudades::anadir(const char* p, int n) {
+    int i = posicion(p, n);
+    if (_tabla[i] >= 0) return _tabla[i];
+
+    int id = _nombres.size();
+    _nombres.push_back(string(p, n));
+    _tabla[i] = id;
+    // Se mantiene la tabla medio vacía para que los sondeos sean cortos.
+    if (2 * _nombres.size() > _tabla.size()) crecer();
+    return id;
+}
+
+// Pre: cierto.
+// Post: La tabla no tiene ningún nombre.
+
+void Tabla_ciudades::vaciar() {
+    _nombres.clear();
+    _tabla.assign(TAM_INICIAL, -1);
+}
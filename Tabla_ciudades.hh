@@ -0,0 +1,119 @@
+/** @file Tabla_ciudades.hh
+    @brief Especificación de la clase Tabla_ciudades.
+*/
+
+#ifndef _TABLA_CIUDADES_HH_
+#define _TABLA_CIUDADES_HH_
+
+#include "Lector.hh"
+
+/** @class Tabla_ciudades
+    @brief Relaciona cada nombre de ciudad con un identificador entero denso.
+
+    Los nombres se internan una sola vez: la primera vez que aparece un nombre
+    recibe el identificador 0, 1, 2..., en orden de aparición, y a partir de ese
+    momento la cuenca trabaja solo con el identificador. La búsqueda se hace
+    sobre la vista de la palabra leída, sin crear strings, en una tabla de
+    dispersión con direccionamiento abierto que crece al llenarse a la mitad.
+*/
+
+class Tabla_ciudades
+{
+
+private:
+  /** @brief Nombre de cada identificador. */
+  vector<string> _nombres;
+  /** @brief Posiciones de la tabla (potencia de dos): identificador, o -1 si está libre. */
+  vector<int> _tabla;
+
+  /** @brief Función de dispersión (FNV-1a) de una palabra.
+      \pre <em>cierto</em>
+      \post Devuelve el hash de los n caracteres de p.
+  */
+  static unsigned int hash(const char* p, int n);
+
+  /** @brief Posición de un nombre en la tabla.
+      \pre La tabla tiene posiciones libres.
+      \post Devuelve la posición que ocupa el nombre de n caracteres p o, si no
+      está, la posición libre donde iría.
+  */
+  int posicion(const char* p, int n) const;
+
+  /** @brief Duplica el tamaño de la tabla.
+      \pre <em>cierto</em>
+      \post La tabla tiene el doble de posiciones y los mismos nombres.
+  */
+  void crecer();
+
+public:
+  // Constructora
+
+  /** @brief Creadora por defecto.
+      \pre <em>cierto</em>
+      \post El resultado es una tabla sin nombres.
+  */
+  Tabla_ciudades();
+
+  // Modificadoras
+
+  /** @brief Interna un nombre.
+      \pre <em>cierto</em>
+      \post Devuelve el identificador del nombre de n caracteres p; si no
+      estaba, se le asigna el siguiente identificador libre.
+  */
+  int anadir(const char* p, int n);
+
+  /** @brief Interna la palabra t. */
+  int anadir(const Token& t) {
+    return anadir(t.p, t.n);
+  }
+
+  /** @brief Interna el string s. */
+  int anadir(const string& s) {
+    return anadir(s.data(), s.size());
+  }
+
+  /** @brief Vacía la tabla.
+      \pre <em>cierto</em>
+      \post La tabla no tiene ningún nombre.
+  */
+  void vaciar();
+
+  // Consultoras
+
+  /** @brief Busca un nombre.
+      \pre <em>cierto</em>
+      \post Devuelve el identificador del nombre de n caracteres p, o -1 si no está.
+  */
+  int buscar(const char* p, int n) const {
+    return _tabla[posicion(p, n)];
+  }
+
+  /** @brief Busca la palabra t. */
+  int buscar(const Token& t) const {
+    return buscar(t.p, t.n);
+  }
+
+  /** @brief Busca el string s. */
+  int buscar(const string& s) const {
+    return buscar(s.data(), s.size());
+  }
+
+  /** @brief Consultora del nombre.
+      \pre 0 <= id < tamano().
+      \post Devuelve el nombre con identificador id.
+  */
+  const string& nombre(int id) const {
+    return _nombres[id];
+  }
+
+  /** @brief Consultora del tamaño.
+      \pre <em>cierto</em>
+      \post Devuelve el número de nombres internados.
+  */
+  int tamano() const {
+    return _nombres.size();
+  }
+};
+
+#endif
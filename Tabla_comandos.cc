@@ -0,0 +1,56 @@
+/** @file Tabla_comandos.cc
+    @brief Código de la clase Tabla_comandos.
+*/
+
+#include "Tabla_comandos.hh"
+
+// Pre: cierto.
+// Post: Devuelve el hash de los n caracteres de p.
+
+unsigned int Tabla_comandos::hash(const char* p, int n) {
+    unsigned int h = 2166136261u;
+    for (int i = 0; i < n; ++i) {
+        h ^= (unsigned char)p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Constructora
+
+// Pre: cierto.
+// Post: El resultado es una tabla sin comandos.
+
+Tabla_comandos::Tabla_comandos() {
+    for (int i = 0; i < TAM; ++i) _tabla[i].nombre = nullptr;
+}
+
+// Modificadoras
+
+// Pre: nombre no estaba registrado y la tabla tiene posiciones libres.
+// Post: La tabla relaciona nombre con codigo.
+
+void Tabla_comandos::registrar(const char* nombre, int codigo) {
+    int lon = strlen(nombre);
+    unsigned int i = hash(nombre, lon) & (TAM - 1);
+    while (_tabla[i].nombre != nullptr) i = (i + 1) & (TAM - 1);
+    _tabla[i].nombre = nombre;
+    _tabla[i].lon = lon;
+    _tabla[i].codigo = codigo;
+}
+
+// Consultoras
+
+// Pre: cierto.
+// Post: Devuelve el código registrado para la palabra t, o -1 si no es un comando.
+
+int Tabla_comandos::buscar(const Token& t) const {
+    unsigned int i = hash(t.p, t.n) & (TAM - 1);
+    while (_tabla[i].nombre != nullptr) {
+        if (_tabla[i].lon == t.n and memcmp(_tabla[i].nombre, t.p, t.n) == 0) {
+            return _tabla[i].codigo;
+        }
+        i = (i + 1) & (TAM - 1);
+    }
+    return -1;
+}
@@ -0,0 +1,67 @@
+/** @file Tabla_comandos.hh
+    @brief Especificación de la clase Tabla_comandos.
+*/
+
+#ifndef _TABLA_COMANDOS_HH_
+#define _TABLA_COMANDOS_HH_
+
+#include "Lector.hh"
+
+/** @class Tabla_comandos
+    @brief Tabla de dispersión que relaciona nombres de comandos con su código.
+
+    Cada comando se registra con su nombre largo y su abreviatura. La búsqueda
+    se hace directamente sobre la vista de la palabra leída, sin crear strings:
+    se calcula un hash de la palabra y se compara con la única entrada
+    candidata (direccionamiento abierto con sondeo lineal).
+*/
+
+class Tabla_comandos
+{
+
+private:
+  /** @brief Número de posiciones de la tabla (potencia de dos). */
+  static const int TAM = 256;
+  /** @brief Entrada de la tabla. */
+  struct Entrada {
+    const char* nombre; // Nulo si la posición está libre.
+    int lon;
+    int codigo;
+  };
+  /** @brief Posiciones de la tabla. */
+  Entrada _tabla[TAM];
+
+  /** @brief Función de dispersión (FNV-1a) de una palabra.
+      \pre <em>cierto</em>
+      \post Devuelve el hash de los n caracteres de p.
+  */
+  static unsigned int hash(const char* p, int n);
+
+public:
+  // Constructora
+
+  /** @brief Creadora por defecto.
+      \pre <em>cierto</em>
+      \post El resultado es una tabla sin comandos.
+  */
+  Tabla_comandos();
+
+  // Modificadoras
+
+  /** @brief Registra un nombre de comando.
+      \pre nombre apunta a una cadena que no se libera mientras exista la tabla,
+      no estaba registrada y la tabla tiene posiciones libres.
+      \post La tabla relaciona nombre con codigo.
+  */
+  void registrar(const char* nombre, int codigo);
+
+  // Consultoras
+
+  /** @brief Busca el código de un comando.
+      \pre <em>cierto</em>
+      \post Devuelve el código registrado para la palabra t, o -1 si no es un comando.
+  */
+  int buscar(const Token& t) const;
+};
+
+#endif
@@ -0,0 +1,70 @@
+/** @file Totales_rio.cc
+    @brief Código de la clase Totales_rio.
+*/
+
+#include "Totales_rio.hh"
+
+// Pre: 0 <= n <= número de nodos.
+// Post: Devuelve el peso y el volumen total de los nodos [0, n).
+
+Totales_rio::Suma Totales_rio::prefijo(int n) const {
+    Suma s = { 0, 0 };
+    for (int k = n; k > 0; k &= k - 1) {
+        s.peso += _arbol[k].peso;
+        s.volumen += _arbol[k].volumen;
+    }
+    return s;
+}
+
+// Modificadoras
+
+// Pre: Las ciudades del río son menores que ciudades.size().
+// Post: Cada nodo del río tiene el peso y el volumen total de su ciudad.
+
+void Totales_rio::reiniciar(const Rio& rio, const vector<Ciudad>& ciudades) {
+    int n = rio.tamano();
+    _nodo.resize(n);
+    _arbol.resize(n + 1);
+    _arbol[0].peso = _arbol[0].volumen = 0;
+    for (int i = 0; i < n; ++i) {
+        const Ciudad& c = ciudades[rio.ciudad(i)];
+        _nodo[i].peso = c.consultar_peso_total();
+        _nodo[i].volumen = c.consultar_volumen_total();
+        _arbol[i + 1] = _nodo[i];
+    }
+    // Cada posición se suma a la siguiente que la cubre: en total, lineal.
+    for (int k = 1; k <= n; ++k) {
+        int siguiente = k + (k & -k);
+        if (siguiente <= n) {
+            _arbol[siguiente].peso += _arbol[k].peso;
+            _arbol[siguiente].volumen += _arbol[k].volumen;
+        }
+    }
+}
+
+// Pre: 0 <= i < número de nodos.
+// Post: El nodo i tiene el peso y el volumen indicados.
+
+void Totales_rio::asignar(int i, int peso, int volumen) {
+    long long dpeso = peso - _nodo[i].peso;
+    long long dvolumen = volumen - _nodo[i].volumen;
+    if (dpeso == 0 and dvolumen == 0) return;
+    _nodo[i].peso = peso;
+    _nodo[i].volumen = volumen;
+    for (int k = i + 1; k < int(_arbol.size()); k += k & -k) {
+        _arbol[k].peso += dpeso;
+        _arbol[k].volumen += dvolumen;
+    }
+}
+
+// Consultoras
+
+// Pre: 0 <= i <= i + n <= número de nodos.
+// Post: peso y volumen son la suma de los nodos [i, i + n).
+
+void Totales_rio::sumar(int i, int n, long long& peso, long long& volumen) const {
+    Suma hasta = prefijo(i + n);
+    Suma desde = prefijo(i);
+    peso = hasta.peso - desde.peso;
+    volumen = hasta.volumen - desde.volumen;
+}
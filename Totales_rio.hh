@@ -0,0 +1,75 @@
+/** @file Totales_rio.hh
+    @brief Especificación de la clase Totales_rio.
+*/
+
+#ifndef _TOTALES_RIO_HH_
+#define _TOTALES_RIO_HH_
+
+#include "Ciudad.hh"
+#include "Rio.hh"
+
+#ifndef NO_DIAGRAM
+#include <vector>
+#endif
+
+using namespace std;
+
+/** @class Totales_rio
+    @brief Peso y volumen total de los subárboles del río.
+
+    Guarda el peso y el volumen total de la ciudad de cada nodo en un árbol
+    de Fenwick indexado por la posición del nodo en preorden. Como el subárbol
+    de un nodo ocupa posiciones consecutivas, su suma es la diferencia de dos
+    prefijos: tanto cambiar un nodo como consultar un subárbol cuestan un
+    tiempo logarítmico en el tamaño del río, sin recorrerlo.
+
+    Peso y volumen van juntos en cada posición, de modo que cada operación
+    recorre el árbol una sola vez para los dos.
+*/
+
+class Totales_rio
+{
+
+private:
+  /** @brief Peso y volumen. */
+  struct Suma {
+    long long peso, volumen;
+  };
+  /** @brief Árbol de Fenwick: la posición k > 0 suma los nodos
+      [k - (k & -k), k). */
+  vector<Suma> _arbol;
+  /** @brief Peso y volumen de cada nodo, tal como están en _arbol. */
+  vector<Suma> _nodo;
+
+  /** @brief Suma de un prefijo.
+      \pre 0 <= n <= número de nodos.
+      \post Devuelve el peso y el volumen total de los nodos [0, n).
+  */
+  Suma prefijo(int n) const;
+
+public:
+  // Modificadoras
+
+  /** @brief Llena los totales para un río.
+      \pre Las ciudades del río son menores que ciudades.size().
+      \post Cada nodo del río tiene el peso y el volumen total de su ciudad.
+      Cuesta un tiempo lineal en el tamaño del río.
+  */
+  void reiniciar(const Rio& rio, const vector<Ciudad>& ciudades);
+
+  /** @brief Cambia los totales de un nodo.
+      \pre 0 <= i < número de nodos.
+      \post El nodo i tiene el peso y el volumen indicados.
+  */
+  void asignar(int i, int peso, int volumen);
+
+  // Consultoras
+
+  /** @brief Consultora de un subárbol.
+      \pre 0 <= i <= i + n <= número de nodos.
+      \post peso y volumen son la suma de los nodos [i, i + n).
+  */
+  void sumar(int i, int n, long long& peso, long long& volumen) const;
+};
+
+#endif
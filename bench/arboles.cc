@@ -0,0 +1,237 @@
+/** @file arboles.cc
+    @brief Medidas de los árboles: BinTree, ArenaBinTree y Rio.
+
+    Uso: arboles.exe rio N | arena N | formatos N
+
+    - rio: recorre todos los pares padre-hijo de un árbol aleatorio de N
+      nodos, sobre un BinTree<int> y sobre un Rio.
+    - arena: construye, recorre y destruye un árbol equilibrado de N nodos
+      como BinTree y como ArenaBinTree, con y sin Region, con valores int y
+      string.
+    - formatos: escribe y lee un árbol equilibrado de N nodos en los
+      formatos POSTORDERFORMAT, INLINEFORMAT y BINARYFORMAT.
+*/
+
+#include "../BinTree.hh"
+#include "../ArenaBinTree.hh"
+#include "../Rio.hh"
+
+#ifndef NO_DIAGRAM
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <vector>
+#endif
+
+using namespace std;
+
+static mt19937 azar(1);
+
+// Pre: cierto.
+// Post: Devuelve el instante actual en segundos.
+
+static double ahora() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Pre: n >= 0.
+// Post: Se han recorrido los pares padre-hijo de un árbol aleatorio de n nodos
+// sobre BinTree y sobre Rio, y se ha escrito el tiempo de cada recorrido.
+
+static void medir_rio(int n) {
+    // Preorden del árbol: el número de nodo, o -1 para un árbol vacío.
+    vector<int> preorden;
+    vector<int> pila(1, n);
+    int id = 0;
+    while (not pila.empty()) {
+        int k = pila.back();
+        pila.pop_back();
+        if (k == 0) {
+            preorden.push_back(-1);
+            continue;
+        }
+        preorden.push_back(id++);
+        int l = azar() % k;
+        pila.push_back(k - 1 - l);
+        pila.push_back(l);
+    }
+
+    // BinTree construido sin recursión: cada nodo espera a su hijo izquierdo.
+    struct Pendiente {
+        int valor;
+        BinTree<int> izq;
+        bool tiene_izq;
+    };
+    vector<Pendiente> pendientes;
+    BinTree<int> hecho;
+    size_t pos = 0;
+    do {
+        int x = preorden[pos++];
+        if (x >= 0) {
+            pendientes.push_back(Pendiente{ x, BinTree<int>(), false });
+            continue;
+        }
+        hecho = BinTree<int>();
+        while (not pendientes.empty() and pendientes.back().tiene_izq) {
+            hecho = BinTree<int>(pendientes.back().valor, pendientes.back().izq, hecho);
+            pendientes.pop_back();
+        }
+        if (not pendientes.empty()) {
+            pendientes.back().izq = hecho;
+            pendientes.back().tiene_izq = true;
+        }
+    } while (not pendientes.empty());
+
+    Rio r;
+    r.empezar();
+    for (int x : preorden) {
+        if (x >= 0) r.nodo(x);
+        else r.vacio();
+    }
+
+    for (int rep = 0; rep < 3; ++rep) {
+        double t0 = ahora();
+        long long s1 = 0;
+        vector<BinTree<int> > cola(1, hecho);
+        while (not cola.empty()) {
+            BinTree<int> t = cola.back();
+            cola.pop_back();
+            if (t.empty()) continue;
+            if (not t.left().empty()) s1 += t.value() ^ t.left().value();
+            if (not t.right().empty()) s1 += t.value() ^ t.right().value();
+            cola.push_back(t.right());
+            cola.push_back(t.left());
+        }
+        double t1 = ahora();
+        long long s2 = 0;
+        for (int i = 1; i < r.tamano(); ++i) s2 += r.ciudad(r.padre(i)) ^ r.ciudad(i);
+        double t2 = ahora();
+        printf("padre-hijo n=%d  BinTree %.2f ms  Rio %.2f ms%s\n", n, (t1 - t0) * 1e3, (t2 - t1) * 1e3,
+               s1 == s2 ? "" : "  (distintos)");
+    }
+}
+
+// Pre: lo <= hi.
+// Post: Devuelve el árbol equilibrado con los valores val[lo..hi-1] en inorden.
+
+template <typename Arbol, typename V>
+static Arbol equilibrado(int lo, int hi, const vector<V>& val) {
+    if (lo >= hi) return Arbol();
+    int mid = (lo + hi) / 2;
+    Arbol l = equilibrado<Arbol, V>(lo, mid, val);
+    Arbol r = equilibrado<Arbol, V>(mid + 1, hi, val);
+    return Arbol(val[mid], l, r);
+}
+
+// Pre: cierto.
+// Post: Devuelve el número de nodos de t.
+
+template <typename Arbol>
+static long long contar(const Arbol& t) {
+    return t.empty() ? 0 : 1 + contar(t.left()) + contar(t.right());
+}
+
+// Pre: cierto.
+// Post: Se ha construido, recorrido y destruido un árbol con los valores val
+// y se ha escrito el tiempo de cada paso.
+
+template <typename Arbol, typename V>
+static void medir_arena(const char* nombre, const vector<V>& val, bool region) {
+    double t0 = ahora();
+    Arbol t;
+    if (region) {
+        typename ArenaBinTree<V>::Region r;
+        t = equilibrado<Arbol, V>(0, val.size(), val);
+    } else {
+        t = equilibrado<Arbol, V>(0, val.size(), val);
+    }
+    double t1 = ahora();
+    long long c = contar(t);
+    double t2 = ahora();
+    t = Arbol();
+    double t3 = ahora();
+    printf("%-28s build %.2fs  walk %.2fs  teardown %.2fs%s\n", nombre, t1 - t0, t2 - t1, t3 - t2,
+           c == (long long)val.size() ? "" : "  (distintos)");
+}
+
+static void medir_arena(int n) {
+    vector<int> enteros(n);
+    vector<string> nombres(n);
+    for (int i = 0; i < n; ++i) {
+        enteros[i] = i;
+        nombres[i] = "c" + to_string(i);
+    }
+    medir_arena<BinTree<int>, int>("BinTree<int>", enteros, false);
+    medir_arena<ArenaBinTree<int>, int>("ArenaBinTree<int>", enteros, false);
+    medir_arena<ArenaBinTree<int>, int>("ArenaBinTree<int>+Region", enteros, true);
+    medir_arena<BinTree<string>, string>("BinTree<string>", nombres, false);
+    medir_arena<ArenaBinTree<string>, string>("ArenaBinTree<string>+Region", nombres, true);
+}
+
+// Pre: n >= 0.
+// Post: Devuelve un árbol casi equilibrado de n nodos con valores de val().
+
+template <typename V>
+static BinTree<V> casi_equilibrado(int n, V (*val)()) {
+    if (n == 0) return BinTree<V>();
+    int l = (n - 1) / 2 + (n > 8 ? int(azar() % 5) - 2 : 0);
+    BinTree<V> a = casi_equilibrado(l, val);
+    BinTree<V> b = casi_equilibrado(n - 1 - l, val);
+    return BinTree<V>(val(), move(a), move(b));
+}
+
+static string nombre_ciudad() {
+    return "ciudad" + to_string(azar() % 1000000);
+}
+
+static int entero() {
+    return int(azar() % 2000001) - 1000000;
+}
+
+// Pre: n >= 0.
+// Post: Se ha escrito y leído un árbol de n nodos en cada formato y se han
+// escrito los tiempos.
+
+template <typename V>
+static void medir_formatos(const char* nombre, int n, V (*val)()) {
+    BinTree<V> t = casi_equilibrado(n, val);
+    const int formatos[] = { BinTree<V>::POSTORDERFORMAT, BinTree<V>::INLINEFORMAT, BinTree<V>::BINARYFORMAT };
+    for (int f : formatos) {
+        ostringstream out;
+        t.setOutputFormat(f);
+        double t0 = ahora();
+        out << t;
+        double t1 = ahora();
+        string s = out.str();
+        BinTree<V> u;
+        u.setInputFormat(f);
+        istringstream in(s);
+        double t2 = ahora();
+        in >> u;
+        double t3 = ahora();
+        printf("%-6s n=%d formato=%d  %.1f MB  escritura %.3fs  lectura %.3fs\n", nombre, n, f, s.size() / 1e6,
+               t1 - t0, t3 - t2);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "uso: %s rio|arena|formatos N\n", argv[0]);
+        return 1;
+    }
+    string que = argv[1];
+    int n = atoi(argv[2]);
+    if (que == "rio") {
+        medir_rio(n);
+    } else if (que == "arena") {
+        medir_arena(n);
+    } else if (que == "formatos") {
+        medir_formatos("string", n, nombre_ciudad);
+        medir_formatos("int", n, entero);
+    } else {
+        fprintf(stderr, "uso: %s rio|arena|formatos N\n", argv[0]);
+        return 1;
+    }
+}
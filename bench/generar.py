@@ -0,0 +1,168 @@
+"""Generador de entradas para las medidas de bench/medir.sh.
+
+Uso:
+  generar.py guion SEMILLA CIUDADES COMANDOS
+      Guion aleatorio con los comandos de ciudades, productos y barco (sin
+      hv ni re, que se miden aparte), para medir la lectura y el reparto de
+      comandos.
+  generar.py rio FORMA N COMANDO VECES [DENSIDAD]
+      Río de N ciudades con FORMA cadena o equilibrado, inventarios de dos
+      productos en una fracción DENSIDAD de las ciudades y VECES veces
+      COMANDO (hv, re, o lr para volver a leer el mismo río).
+  generar.py comercio DENSIDAD_A DENSIDAD_B VECES
+      Dos ciudades sobre 4000 productos con las densidades dadas y VECES
+      comerciar entre ellas.
+
+La entrada se escribe en el canal estándar de salida. Con la misma semilla
+y los mismos argumentos la entrada es siempre la misma.
+"""
+
+import random
+import sys
+
+
+def productos(R, n):
+    return [str(n)] + ["%d %d" % (R.randint(1, 30), R.randint(1, 30)) for _ in range(n)]
+
+
+def rio_forma(forma, n):
+    """Preorden de un río de n ciudades c0..c(n-1), sin recursión."""
+    out = []
+    if forma == "cadena":
+        for i in range(n):
+            out.append("c%d" % i)
+            out.append("#")
+        out.append("#")
+        return out
+    pila = [n]
+    k = 0
+    while pila:
+        m = pila.pop()
+        if m == 0:
+            out.append("#")
+            continue
+        out.append("c%d" % k)
+        k += 1
+        izq = (m - 1) // 2
+        pila.append(m - 1 - izq)
+        pila.append(izq)
+    return out
+
+
+def rio_aleatorio(R, nombres):
+    out = []
+    pila = [len(nombres)]
+    while pila:
+        m = pila.pop()
+        if m == 0:
+            out.append("#")
+            continue
+        out.append(nombres.pop())
+        izq = R.randint(0, m - 1)
+        pila.append(m - 1 - izq)
+        pila.append(izq)
+    return out
+
+
+def guion(semilla, num_ciudades, num_comandos):
+    R = random.Random(semilla)
+    P = 40
+    out = productos(R, P)
+    nombres = ["c%d" % i for i in range(num_ciudades)]
+    ciudades = nombres[:]
+    out += rio_aleatorio(R, nombres)
+    out.append("1 %d 2 %d" % (R.randint(1, 50), R.randint(1, 50)))
+
+    def inventario():
+        ids = sorted(R.sample(range(1, P + 1), R.randint(0, 12)))
+        return " ".join([str(len(ids))] + ["%d %d %d" % (i, R.randint(0, 20), R.randint(1, 20)) for i in ids])
+
+    out.append("ls")
+    for c in ciudades:
+        out.append("%s %s" % (c, inventario()))
+    out.append("#")
+    for _ in range(num_comandos):
+        r = R.random()
+        c = R.choice(ciudades)
+        if r < 0.15:
+            out.append("pp %s %d %d %d" % (c, R.randint(1, P), R.randint(0, 20), R.randint(1, 20)))
+        elif r < 0.30:
+            out.append("mp %s %d %d %d" % (c, R.randint(1, P), R.randint(0, 20), R.randint(1, 20)))
+        elif r < 0.40:
+            out.append("qp %s %d" % (c, R.randint(1, P)))
+        elif r < 0.55:
+            out.append("cp %s %d" % (c, R.randint(1, P)))
+        elif r < 0.65:
+            out.append("co %s %s" % (c, R.choice(ciudades)))
+        elif r < 0.72:
+            out.append("li %s %s" % (c, inventario()))
+        elif r < 0.80:
+            out.append("ec %s" % c)
+        elif r < 0.87:
+            out.append("ep %d" % R.randint(1, P))
+        elif r < 0.92:
+            out.append("mb %d %d %d %d" % (1, R.randint(0, 50), 2, R.randint(0, 50)))
+        elif r < 0.96:
+            out.append("eb")
+        else:
+            out.append("cn")
+    out.append("fin")
+    return out
+
+
+def rio(forma, n, comando, veces, densidad):
+    R = random.Random(7)
+    out = ["3", "1 1", "2 2", "3 3"]
+    descripcion = rio_forma(forma, n)
+    out += descripcion
+    out.append("1 %d 2 %d" % (10**9, 10**9))
+    out.append("ls")
+    for i in range(n):
+        if R.random() < densidad:
+            out.append("c%d 2 1 %d %d 2 %d %d" % (i, R.randint(0, 9), R.randint(1, 9), R.randint(0, 9), R.randint(1, 9)))
+    out.append("#")
+    for _ in range(veces):
+        if comando == "lr":
+            out.append("lr")
+            out += descripcion
+        else:
+            out.append(comando)
+    out.append("fin")
+    return out
+
+
+def comercio(densidad_a, densidad_b, veces):
+    R = random.Random(3)
+    n = 4000
+    out = productos(R, n)
+    out += ["a", "b", "#", "#", "#", "1 1 2 1", "ls"]
+    for c, d in (("a", densidad_a), ("b", densidad_b)):
+        ids = [i for i in range(1, n + 1) if R.random() < d]
+        out.append(c)
+        out.append(str(len(ids)))
+        out += ["%d %d %d" % (i, R.randint(0, 20), R.randint(1, 20)) for i in ids]
+    out.append("#")
+    out += ["co a b"] * veces
+    out.append("ec a")
+    out.append("fin")
+    return out
+
+
+def main(args):
+    if len(args) >= 4 and args[0] == "guion":
+        out = guion(int(args[1]), int(args[2]), int(args[3]))
+    elif len(args) >= 5 and args[0] == "rio" and args[1] in ("cadena", "equilibrado"):
+        densidad = float(args[5]) if len(args) > 5 else 0.3
+        out = rio(args[1], int(args[2]), args[3], int(args[4]), densidad)
+    elif len(args) == 4 and args[0] == "comercio":
+        out = comercio(float(args[1]), float(args[2]), int(args[3]))
+    else:
+        sys.stderr.write(__doc__)
+        return 1
+    sys.stdout.write("\n".join(out))
+    sys.stdout.write("\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,130 @@
+#!/bin/bash
+# Medidas de rendimiento del simulador y de sus estructuras.
+#
+# Uso: bench/medir.sh [PROGRAMA_BASE]
+#
+# Compila en un directorio aparte una versión sin -D_GLIBCXX_DEBUG del
+# programa y de los programas de medida de bench/, genera las entradas con
+# bench/generar.py y escribe el tiempo de cada caso. Si se da un programa
+# base (por ejemplo, program.exe compilado igual desde una versión anterior),
+# los casos del simulador se miden también con él, para comparar.
+#
+# Los tamaños se pueden cambiar con variables de entorno; los valores por
+# defecto son los de las cifras citadas en los cambios correspondientes.
+
+set -e
+
+raiz=$(cd "$(dirname "$0")/.." && pwd)
+base=${1:+$(cd "$(dirname "$1")" && pwd)/$(basename "$1")}
+trabajo=$(mktemp -d)
+trap 'rm -rf "$trabajo"' EXIT
+
+COMANDOS=${COMANDOS:-1000000}       # Comandos del guion aleatorio.
+CIUDADES=${CIUDADES:-2000}          # Ciudades del guion aleatorio.
+RIO=${RIO:-1000000}                 # Ciudades de los ríos grandes.
+CADENA_CORTA=${CADENA_CORTA:-20000} # Ciudades de la cadena para hv sin planificación lineal.
+VECES=${VECES:-5}                   # Repeticiones de hv y re.
+CO=${CO:-50000}                     # Repeticiones de co.
+ARENA=${ARENA:-10000000}            # Nodos de los árboles de ArenaBinTree.
+FORMATOS=${FORMATOS:-1000000}       # Nodos de los árboles de los formatos.
+
+# Las opciones del Makefile, sin las comprobaciones de la biblioteca estándar.
+opciones=$(sed -n 's/^OPCIONS = //p' "$raiz/Makefile" | sed 's/ -D_GLIBCXX_DEBUG//')
+
+echo "Compilando en $trabajo"
+cp "$raiz"/*.cc "$raiz"/*.hh "$raiz"/Makefile "$trabajo"
+mkdir "$trabajo/bench"
+cp "$raiz"/bench/*.cc "$trabajo/bench"
+make -s -C "$trabajo" OPCIONS="$opciones" program.exe > /dev/null
+g++ $opciones -o "$trabajo/arboles.exe" "$trabajo/bench/arboles.cc" "$trabajo/Rio.o"
+g++ $opciones -o "$trabajo/nucleos.exe" "$trabajo/bench/nucleos.cc"
+
+generar() {
+    python3 "$raiz/bench/generar.py" "$@"
+}
+
+# tiempo PROGRAMA ARGS... < ENTRADA: segundos de reloj de una ejecución, o
+# "error" si el programa termina mal (un programa base puede no admitir
+# alguna opción).
+tiempo() {
+    local t0 t1
+    t0=$(date +%s%N)
+    if ! "$@" > /dev/null 2>&1; then
+        echo "error"
+        return
+    fi
+    t1=$(date +%s%N)
+    echo "$(( (t1 - t0) / 1000000 ))" | awk '{ printf "%.3fs", $1 / 1000 }'
+}
+
+# caso NOMBRE ENTRADA [OPCIONES...]: tiempo del programa nuevo y del base.
+caso() {
+    local nombre=$1 entrada=$2
+    shift 2
+    local linea
+    linea=$(printf '  %-40s %8s' "$nombre" "$(tiempo "$trabajo/program.exe" "$@" < "$entrada")")
+    if [ -n "$base" ]; then
+        linea="$linea$(printf '   base %8s' "$(tiempo "$base" "$@" < "$entrada")")"
+    fi
+    echo "$linea"
+}
+
+e=$trabajo/entrada
+
+echo
+echo "Lectura y reparto de comandos: guion aleatorio de $COMANDOS comandos"
+generar guion 1 "$CIUDADES" "$COMANDOS" > "$e.guion"
+mb=$(du -m "$e.guion" | cut -f1)
+caso "entrada estándar ($mb MB)" "$e.guion"
+t=$(tiempo "$trabajo/program.exe" "$e.guion" < /dev/null)
+printf '  %-40s %8s\n' "fichero proyectado ($mb MB)" "$t"
+
+echo
+echo "Lectura del río: cadena de $RIO ciudades, leída y sustituida dos veces"
+generar rio cadena "$RIO" lr 2 > "$e.lr"
+caso "lr" "$e.lr"
+
+echo
+echo "Recorrido padre-hijo sobre BinTree y sobre Rio"
+"$trabajo/arboles.exe" rio "$RIO" | sed 's/^/  /'
+
+echo
+echo "Planificación de viajes: $VECES hv"
+generar rio cadena "$CADENA_CORTA" hv "$VECES" > "$e.hv_corta"
+generar rio cadena "$RIO" hv "$VECES" > "$e.hv_cadena"
+generar rio equilibrado "$RIO" hv "$VECES" > "$e.hv_equilibrado"
+caso "cadena de $CADENA_CORTA" "$e.hv_corta"
+caso "cadena de $RIO" "$e.hv_cadena"
+caso "equilibrado de $RIO" "$e.hv_equilibrado"
+
+echo
+echo "Planificación con hilos: $VECES hv, árbol equilibrado de $RIO"
+for t in 1 2 4; do
+    caso "-t $t" "$e.hv_equilibrado" -t "$t"
+done
+
+echo
+echo "Redistribución con hilos: $VECES re, árbol equilibrado de $RIO"
+generar rio equilibrado "$RIO" re "$VECES" 1 > "$e.re"
+for t in 1 2 4; do
+    caso "-t $t" "$e.re" -t "$t"
+done
+
+echo
+echo "Núcleos de comerciar: microsegundos por comercio"
+"$trabajo/nucleos.exe" | sed 's/^/  /'
+
+echo
+echo "Comerciar: $CO co entre dos ciudades de 4000 productos"
+for d in "1 1" "1 0.97" "0.99 0.99" "0.5 0.5"; do
+    generar comercio $d "$CO" > "$e.co"
+    caso "densidades $d" "$e.co"
+done
+
+echo
+echo "ArenaBinTree: árbol equilibrado de $ARENA nodos"
+"$trabajo/arboles.exe" arena "$ARENA" | sed 's/^/  /'
+
+echo
+echo "Formatos de BinTree: árbol de $FORMATOS nodos"
+"$trabajo/arboles.exe" formatos "$FORMATOS" | sed 's/^/  /'
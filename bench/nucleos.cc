@@ -0,0 +1,130 @@
+/** @file nucleos.cc
+    @brief Medida de los núcleos de comerciar.
+
+    Compara, en microsegundos por comercio, la mezcla original de
+    Ciudad::comerciar con cada versión de intercambios(): producto a
+    producto, SSE4.2 y AVX2. Cada caso son dos inventarios sacados de 4000
+    productos con las densidades indicadas, ya compensados por un primer
+    comercio, como cuando se repite co entre las mismas ciudades. Se incluye
+    el código de los núcleos para poder llamar a cada versión.
+*/
+
+#include "../Nucleos_comercio.cc"
+
+#ifndef NO_DIAGRAM
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#endif
+
+using namespace std;
+
+/** @brief Inventario con sus vectores, para construir las vistas. */
+struct Inventario {
+    vector<int> ids, tiene, necesita;
+
+    Vista_inventario vista() const {
+        Vista_inventario v = { ids.data(), tiene.data(), necesita.data(), int(ids.size()) };
+        return v;
+    }
+};
+
+// Pre: Las de intercambios().
+// Post: Las de intercambios(), con la mezcla de Ciudad::comerciar.
+
+static int mezcla_original(const Vista_inventario& a, const Vista_inventario& b,
+                           int* pos_a, int* pos_b, int* balance) {
+    int i = 0;
+    int j = 0;
+    int k = 0;
+    while (i < a.n and j < b.n) {
+        int id1 = a.ids[i];
+        int id2 = b.ids[j];
+        if (id1 == id2) {
+            int excedente1 = a.tiene[i] - a.necesita[i];
+            int excedente2 = b.tiene[j] - b.necesita[j];
+            int min_balance = 0;
+            if (excedente1 > 0 and excedente2 < 0) min_balance = min(excedente1, -excedente2);
+            else if (excedente1 < 0 and excedente2 > 0) min_balance = -min(-excedente1, excedente2);
+            if (min_balance != 0) {
+                pos_a[k] = i;
+                pos_b[k] = j;
+                balance[k] = min_balance;
+                ++k;
+            }
+            ++i;
+            ++j;
+        } else if (id1 < id2) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+    return k;
+}
+
+// Pre: 0 <= densidad <= 1.
+// Post: Devuelve un inventario con cada uno de los productos 1..n con
+// probabilidad densidad.
+
+static Inventario inventario(mt19937& azar, int n, double densidad) {
+    Inventario inv;
+    uniform_real_distribution<double> u(0, 1);
+    for (int id = 1; id <= n; ++id) {
+        if (u(azar) < densidad) {
+            inv.ids.push_back(id);
+            inv.tiene.push_back(azar() % 21);
+            inv.necesita.push_back(1 + azar() % 20);
+        }
+    }
+    return inv;
+}
+
+// Pre: cierto.
+// Post: Devuelve los microsegundos por comercio de la mezcla m sobre a y b,
+// el mejor de varios intentos; k es el número de intercambios que da.
+
+static double medir(Mezcla m, const Inventario& a, const Inventario& b, int& k) {
+    Vista_inventario va = a.vista();
+    Vista_inventario vb = b.vista();
+    vector<int> pos_a(a.ids.size() + HOLGURA), pos_b(a.ids.size() + HOLGURA), balance(a.ids.size() + HOLGURA);
+    const int REPETICIONES = 20000;
+    double mejor = 1e30;
+    for (int intento = 0; intento < 5; ++intento) {
+        auto t0 = chrono::steady_clock::now();
+        for (int r = 0; r < REPETICIONES; ++r) k = m(va, vb, pos_a.data(), pos_b.data(), balance.data());
+        double us = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count() / REPETICIONES;
+        mejor = min(mejor, us);
+    }
+    return mejor;
+}
+
+int main() {
+    const int N = 4000;
+    const double densidades[][2] = { { 1, 1 }, { 1, 0.97 }, { 0.99, 0.99 }, { 0.9, 0.9 } };
+    mezcla_elegida(); // Prepara las tablas de compactación.
+    mt19937 azar(3);
+    for (const auto& d : densidades) {
+        Inventario a = inventario(azar, N, d[0]);
+        Inventario b = inventario(azar, N, d[1]);
+        if (a.ids.size() > b.ids.size()) swap(a, b);
+
+        // Primer comercio: a partir de aquí los inventarios están compensados.
+        vector<int> pos_a(a.ids.size() + HOLGURA), pos_b(a.ids.size() + HOLGURA), balance(a.ids.size() + HOLGURA);
+        int k = mezcla_original(a.vista(), b.vista(), pos_a.data(), pos_b.data(), balance.data());
+        for (int t = 0; t < k; ++t) {
+            a.tiene[pos_a[t]] -= balance[t];
+            b.tiene[pos_b[t]] += balance[t];
+        }
+
+        printf("%3.0f%%/%3.0f%%  bloques=%d", d[0] * 100, d[1] * 100, int(por_bloques(a.vista(), b.vista())));
+        printf("  original %.2f us", medir(mezcla_original, a, b, k));
+        printf("  escalar %.2f us", medir(mezcla_escalar, a, b, k));
+#ifdef NUCLEOS_X86
+        if (__builtin_cpu_supports("sse4.2")) printf("  sse %.2f us", medir(mezcla_sse, a, b, k));
+        if (__builtin_cpu_supports("avx2")) printf("  avx2 %.2f us", medir(mezcla_avx2, a, b, k));
+#endif
+        printf("\n");
+    }
+}
@@ -50,6 +50,47 @@
  * - `comerciar` (`co`): Realiza una acción de comercio entre dos ciudades.
  * - `redistribuir` (`re`): Redistribuye los productos entre las ciudades para optimizar los inventarios.
  * - `hacer_viaje` (`hv`): Realiza un viaje comercial con el barco.
+ * - `guardar_estado` (`ge`): Guarda el estado completo en un fichero binario.
+ * - `cargar_estado` (`ce`): Recupera el estado completo de un fichero binario.
+ * - `consultar_cache` (`cc`): Escribe cuántos subárboles ha reutilizado la
+ *   planificación de `hacer_viaje` (aciertos) y cuántos nodos ha recalculado (fallos).
+ * - `comerciar_lote` (`cl`): Lee un número n y n parejas de ciudades, y hace
+ *   `comerciar` con cada pareja en orden. Con varios hilos, las parejas que no
+ *   comparten ninguna ciudad comercian a la vez.
+ * - `simular_viajes` (`sv`): Lee un número k y k barcos con el formato de
+ *   `modificar_barco`, y escribe para cada uno lo que compraría y vendería con
+ *   `hacer_viaje` y la primera y la última ciudad de su ruta, sin modificar nada.
+ * - `modificar_flota` (`mf`): Como `modificar_barco` para el barco de la flota
+ *   con el identificador dado, que se crea si no existe.
+ * - `escribir_flota` (`ef`): Como `escribir_barco` para un barco de la flota.
+ * - `viajes_flota` (`vf`): Lee un número n y n identificadores de barcos de la
+ *   flota, y hace `hacer_viaje` con cada uno en ese orden. Las rutas se
+ *   planifican a la vez; el primero de la lista se queda con lo que quieran varios.
+ * - `excedentes_prod` (`xp`): Escribe cuánto sobra de un producto en total y
+ *   en cuántas ciudades, y lo que le sobra a cada una.
+ * - `deficits_prod` (`dp`): Lo mismo con lo que falta de un producto.
+ * - `totales_prod` (`tp`): Escribe cuánto sobra y cuánto falta en total de
+ *   todos los productos en todas las ciudades.
+ * - `totales_afluente` (`ta`): Escribe el peso y el volumen total de una
+ *   ciudad y de todas las que están río arriba de ella.
+ * - `distancia_rio` (`dr`): Escribe cuántos tramos de río separan dos ciudades.
+ * - `camino_rio` (`cr`): Escribe cuántas ciudades hay en el camino por el río
+ *   entre dos ciudades y, en orden, cada una de ellas.
+ * 
+ * @subsection opciones Opciones
+ *
+ * - `-i`: modo interactivo, la salida de cada comando se escribe en cuanto termina.
+ *   Sin esta opción la salida se acumula y se escribe por bloques.
+ * - `fichero`: lee los comandos del fichero, proyectándolo en memoria, en lugar
+ *   del canal estándar de entrada.
+ * - `-t hilos`: reparte entre ese número de hilos las operaciones que se pueden
+ *   hacer en paralelo, como planificar la ruta de `hacer_viaje`. El resultado es
+ *   el mismo que con un solo hilo, que es lo que se usa por defecto.
+ * - `-c corte`: tamaño mínimo de un subárbol del río para repartirlo entre hilos.
+ * - `-d diario`: anota en el fichero diario los comandos que modifican el estado.
+ *   Si el diario ya tiene anotaciones (por ejemplo, tras una caída), al arrancar
+ *   se vuelven a aplicar sin escribir nada y la entrada continúa directamente
+ *   con los comandos, sin la lectura inicial.
  * 
  */
 
@@ -57,130 +98,433 @@
 #include "Cjt_productos.hh"
 #include "Cuenca.hh"
 #include "Barco.hh"
+#include "Lector.hh"
+#include "Tabla_comandos.hh"
+#include "Diario.hh"
+#include "Pool_hilos.hh"
+#include "Flota.hh"
+
+#ifndef NO_DIAGRAM
+#include <cstdlib>
+#endif
 
-int main() {
+/** @brief Estado completo de la simulación sobre el que actúan los comandos. */
+struct Estado {
     Cuenca c;
     Cjt_productos cp;
     Barco b;
+    Flota f;
+    Diario* diario = nullptr; // Donde se anotan las imágenes cargadas, si hay diario.
+};
 
-    c.lectura_inicial(cp, b);
-    
-   // COMANDOS
-   
-    string op;
-    while (cin >> op and op != "fin") {
-        if (op == "leer_rio" or op == "lr") {
-            cout << '#' << op << endl;
-            c.leer_rio();
-            b.reiniciar_lista();
-        }
+// Cada comando se atiende con una función que lee sus argumentos del lector,
+// escribe el eco con el nombre tal como se ha leído (op) y ejecuta la operación.
 
-        else if (op == "leer_inventario" or op == "li") {
-            string id_ciudad;
-            cin >> id_ciudad;
-            cout << '#' << op << ' ' << id_ciudad << endl;
-            c.leer_inventario(id_ciudad, cp);
-        }
+static void op_leer_rio(Estado& e, Lector& in, const char* op) {
+    salida << '#' << op << '\n';
+    e.c.leer_rio(in);
+    e.b.reiniciar_lista();
+    e.f.reiniciar_listas();
+}
 
-        else if (op == "leer_inventarios" or op == "ls") {
-            cout << '#' << op << endl;
-            c.leer_inventarios(cp);
-        }
+static void op_leer_inventario(Estado& e, Lector& in, const char* op) {
+    string id_ciudad = in.leer_string();
+    salida << '#' << op << ' ' << id_ciudad << '\n';
+    e.c.leer_inventario(id_ciudad, e.cp, in);
+}
 
-        else if (op == "modificar_barco" or op == "mb") {
-            int id_producto_comprar, num_comprar, id_producto_vender, num_vender;
-            cin >> id_producto_comprar >> num_comprar >> id_producto_vender >> num_vender;
-            cout << '#' << op << endl;
-            b.modificar_barco(id_producto_comprar, num_comprar, id_producto_vender, num_vender, cp);
-        }
-        
-        else if (op == "escribir_barco" or op == "eb") {
-            cout << '#' << op << endl;
-            b.escribir_barco();
-        }
-        
-        else if (op == "consultar_num" or op == "cn") {
-            cout << '#' << op << endl;
-            cout << cp.consultar_num() << endl;
-        }
-        
-        else if (op == "agregar_productos" or op == "ap") {
-            int num_productos;
-            cin >> num_productos;
-            cout << '#' << op << ' ' << num_productos << endl;
-            cp.agregar_productos(num_productos);
-        }
-        
-        else if (op == "escribir_producto" or op == "ep") {
-            int id_producto;
-            cin >> id_producto;
-            cout << '#' << op << ' ' << id_producto << endl;
-            cp.escribir_producto(id_producto);
-        }
-        
-        else if (op == "escribir_ciudad" or op == "ec") {
-            string id_ciudad;
-            cin >> id_ciudad;   
-            cout << '#' << op << ' ' << id_ciudad << endl;
-            c.escribir_ciudad(id_ciudad);
-        }
-        
-        else if (op == "poner_prod" or op == "pp") {
-            string id_ciudad;
-            int id_producto;
-            int prod_tiene;
-            int prod_necesita;
-            cin >> id_ciudad >> id_producto >> prod_tiene >> prod_necesita;
-            cout << '#' << op << ' ' << id_ciudad << ' ' << id_producto << endl;
-            c.poner_prod(id_ciudad, id_producto, prod_tiene, prod_necesita, cp);
-        }
-        
-        else if (op == "modificar_prod" or op == "mp") {
-            string id_ciudad;
-            int id_producto;
-            int prod_tiene;
-            int prod_necesita;
-            cin >> id_ciudad >> id_producto >> prod_tiene >> prod_necesita;
-            cout << '#' << op << ' ' << id_ciudad << ' ' << id_producto << endl;
-            c.modificar_prod(id_ciudad, id_producto, prod_tiene, prod_necesita, cp);
-        }
-        
-        else if (op == "quitar_prod" or op == "qp") {
-            string id_ciudad;
-            int id_producto;
-            cin >> id_ciudad >> id_producto;
-            cout << '#' << op << ' ' << id_ciudad << ' ' << id_producto << endl;
-            c.quitar_prod(id_ciudad, id_producto, cp);
+static void op_leer_inventarios(Estado& e, Lector& in, const char* op) {
+    salida << '#' << op << '\n';
+    e.c.leer_inventarios(e.cp, in);
+}
+
+static void op_modificar_barco(Estado& e, Lector& in, const char* op) {
+    int id_producto_comprar = in.leer_entero();
+    int num_comprar = in.leer_entero();
+    int id_producto_vender = in.leer_entero();
+    int num_vender = in.leer_entero();
+    salida << '#' << op << '\n';
+    e.b.modificar_barco(id_producto_comprar, num_comprar, id_producto_vender, num_vender, e.cp);
+}
+
+static void op_escribir_barco(Estado& e, Lector&, const char* op) {
+    salida << '#' << op << '\n';
+    e.b.escribir_barco();
+}
+
+static void op_consultar_num(Estado& e, Lector&, const char* op) {
+    salida << '#' << op << '\n';
+    salida << e.cp.consultar_num() << '\n';
+}
+
+static void op_agregar_productos(Estado& e, Lector& in, const char* op) {
+    int num_productos = in.leer_entero();
+    salida << '#' << op << ' ' << num_productos << '\n';
+    e.cp.agregar_productos(num_productos, in);
+}
+
+static void op_escribir_producto(Estado& e, Lector& in, const char* op) {
+    int id_producto = in.leer_entero();
+    salida << '#' << op << ' ' << id_producto << '\n';
+    e.cp.escribir_producto(id_producto);
+}
+
+static void op_escribir_ciudad(Estado& e, Lector& in, const char* op) {
+    string id_ciudad = in.leer_string();
+    salida << '#' << op << ' ' << id_ciudad << '\n';
+    e.c.escribir_ciudad(id_ciudad);
+}
+
+static void op_poner_prod(Estado& e, Lector& in, const char* op) {
+    string id_ciudad = in.leer_string();
+    int id_producto = in.leer_entero();
+    int prod_tiene = in.leer_entero();
+    int prod_necesita = in.leer_entero();
+    salida << '#' << op << ' ' << id_ciudad << ' ' << id_producto << '\n';
+    e.c.poner_prod(id_ciudad, id_producto, prod_tiene, prod_necesita, e.cp);
+}
+
+static void op_modificar_prod(Estado& e, Lector& in, const char* op) {
+    string id_ciudad = in.leer_string();
+    int id_producto = in.leer_entero();
+    int prod_tiene = in.leer_entero();
+    int prod_necesita = in.leer_entero();
+    salida << '#' << op << ' ' << id_ciudad << ' ' << id_producto << '\n';
+    e.c.modificar_prod(id_ciudad, id_producto, prod_tiene, prod_necesita, e.cp);
+}
+
+static void op_quitar_prod(Estado& e, Lector& in, const char* op) {
+    string id_ciudad = in.leer_string();
+    int id_producto = in.leer_entero();
+    salida << '#' << op << ' ' << id_ciudad << ' ' << id_producto << '\n';
+    e.c.quitar_prod(id_ciudad, id_producto, e.cp);
+}
+
+static void op_consultar_prod(Estado& e, Lector& in, const char* op) {
+    string id_ciudad = in.leer_string();
+    int id_producto = in.leer_entero();
+    salida << '#' << op << ' ' << id_ciudad << ' ' << id_producto << '\n';
+    e.c.consultar_prod_ciudad(id_ciudad, id_producto, e.cp);
+}
+
+static void op_comerciar(Estado& e, Lector& in, const char* op) {
+    string id_ciudad1 = in.leer_string();
+    string id_ciudad2 = in.leer_string();
+    salida << '#' << op << ' ' << id_ciudad1 << ' ' << id_ciudad2 << '\n';
+    e.c.comerciar(id_ciudad1, id_ciudad2, e.cp);
+}
+
+static void op_redistribuir(Estado& e, Lector&, const char* op) {
+    salida << '#' << op << '\n';
+    e.c.redistribuir(e.cp);
+}
+
+static void op_hacer_viaje(Estado& e, Lector&, const char* op) {
+    salida << '#' << op << '\n';
+    e.c.hacer_viaje(e.b, e.cp);
+}
+
+static void op_guardar_estado(Estado& e, Lector& in, const char* op) {
+    string fichero = in.leer_string();
+    salida << '#' << op << ' ' << fichero << '\n';
+    e.c.guardar_estado(fichero, e.cp, e.b, e.f);
+}
+
+/** @brief Código con el que se anota en el diario una imagen cargada. */
+static const int IMAGEN_ESTADO = Diario::MAX_CODIGO - 1;
+
+static void op_cargar_estado(Estado& e, Lector& in, const char* op) {
+    string fichero = in.leer_string();
+    if (e.diario == nullptr) {
+        salida << '#' << op << ' ' << fichero << '\n';
+        Lector_binario imagen(fichero);
+        e.c.cargar_estado(imagen, e.cp, e.b, e.f);
+        return;
+    }
+
+    // Con diario se anota la imagen y no el nombre del fichero: al recuperar,
+    // el fichero puede haber cambiado o ya no existir. Como en los demás
+    // comandos que modifican el estado, la salida espera a la anotación.
+    salida.retener(true);
+    salida << '#' << op << ' ' << fichero << '\n';
+    vector<char> datos;
+    Lector_binario::leer_todo(fichero, datos);
+    Lector_binario imagen(datos.data(), datos.size());
+    if (e.c.cargar_estado(imagen, e.cp, e.b, e.f)) {
+        e.diario->anotar(IMAGEN_ESTADO, Token{ datos.data(), int(datos.size()) });
+    }
+    salida.retener(false);
+}
+
+static void op_consultar_cache(Estado& e, Lector&, const char* op) {
+    salida << '#' << op << '\n';
+    salida << e.c.aciertos_plan() << ' ' << e.c.fallos_plan() << '\n';
+}
+
+static void op_comerciar_lote(Estado& e, Lector& in, const char* op) {
+    int n = in.leer_entero();
+    vector<pair<string, string> > pares(n);
+    for (int k = 0; k < n; ++k) {
+        pares[k].first = in.leer_string();
+        pares[k].second = in.leer_string();
+    }
+    salida << '#' << op << ' ' << n << '\n';
+    e.c.comerciar_lote(pares, e.cp);
+}
+
+static void op_simular_viajes(Estado& e, Lector& in, const char* op) {
+    int k = in.leer_entero();
+    vector<Barco> barcos;
+    barcos.reserve(k);
+    for (int j = 0; j < k; ++j) {
+        int id_producto_comprar = in.leer_entero();
+        int num_comprar = in.leer_entero();
+        int id_producto_vender = in.leer_entero();
+        int num_vender = in.leer_entero();
+        barcos.push_back(Barco(id_producto_comprar, num_comprar, id_producto_vender, num_vender));
+    }
+    salida << '#' << op << ' ' << k << '\n';
+    e.c.simular_viajes(barcos, e.cp);
+}
+
+static void op_modificar_flota(Estado& e, Lector& in, const char* op) {
+    int id = in.leer_entero();
+    int id_producto_comprar = in.leer_entero();
+    int num_comprar = in.leer_entero();
+    int id_producto_vender = in.leer_entero();
+    int num_vender = in.leer_entero();
+    salida << '#' << op << ' ' << id << '\n';
+    e.f.modificar_barco(id, id_producto_comprar, num_comprar, id_producto_vender, num_vender, e.cp);
+}
+
+static void op_escribir_flota(Estado& e, Lector& in, const char* op) {
+    int id = in.leer_entero();
+    salida << '#' << op << ' ' << id << '\n';
+    e.f.escribir_barco(id);
+}
+
+static void op_viajes_flota(Estado& e, Lector& in, const char* op) {
+    int n = in.leer_entero();
+    vector<int> ids(n);
+    for (int k = 0; k < n; ++k) ids[k] = in.leer_entero();
+    salida << '#' << op << ' ' << n << '\n';
+    e.f.hacer_viajes(ids, e.c, e.cp);
+}
+
+static void op_excedentes_prod(Estado& e, Lector& in, const char* op) {
+    int id_producto = in.leer_entero();
+    salida << '#' << op << ' ' << id_producto << '\n';
+    e.c.escribir_excedentes(id_producto, e.cp);
+}
+
+static void op_deficits_prod(Estado& e, Lector& in, const char* op) {
+    int id_producto = in.leer_entero();
+    salida << '#' << op << ' ' << id_producto << '\n';
+    e.c.escribir_deficits(id_producto, e.cp);
+}
+
+static void op_totales_prod(Estado& e, Lector&, const char* op) {
+    salida << '#' << op << '\n';
+    e.c.escribir_totales();
+}
+
+static void op_totales_afluente(Estado& e, Lector& in, const char* op) {
+    string id_ciudad = in.leer_string();
+    salida << '#' << op << ' ' << id_ciudad << '\n';
+    e.c.escribir_afluente(id_ciudad);
+}
+
+static void op_distancia_rio(Estado& e, Lector& in, const char* op) {
+    string id_ciudad1 = in.leer_string();
+    string id_ciudad2 = in.leer_string();
+    salida << '#' << op << ' ' << id_ciudad1 << ' ' << id_ciudad2 << '\n';
+    e.c.escribir_distancia(id_ciudad1, id_ciudad2);
+}
+
+static void op_camino_rio(Estado& e, Lector& in, const char* op) {
+    string id_ciudad1 = in.leer_string();
+    string id_ciudad2 = in.leer_string();
+    salida << '#' << op << ' ' << id_ciudad1 << ' ' << id_ciudad2 << '\n';
+    e.c.escribir_camino(id_ciudad1, id_ciudad2);
+}
+
+static void op_comentario(Estado&, Lector& in, const char*) {
+    in.saltar_linea();
+}
+
+/** @brief Comando con su nombre, su abreviatura y la función que lo atiende. */
+struct Comando {
+    const char* nombre;
+    const char* abreviatura;
+    void (*atender)(Estado& e, Lector& in, const char* op);
+    bool modifica; // Si cambia el estado, y por tanto se anota en el diario.
+};
+
+/** @brief Comandos reconocidos. El código de un comando es su posición en la tabla
+    (y es lo que se guarda en el diario: los comandos nuevos van al final). */
+static const Comando COMANDOS[] = {
+    { "leer_rio",          "lr", op_leer_rio,          true },
+    { "leer_inventario",   "li", op_leer_inventario,   true },
+    { "leer_inventarios",  "ls", op_leer_inventarios,  true },
+    { "modificar_barco",   "mb", op_modificar_barco,   true },
+    { "escribir_barco",    "eb", op_escribir_barco,    false },
+    { "consultar_num",     "cn", op_consultar_num,     false },
+    { "agregar_productos", "ap", op_agregar_productos, true },
+    { "escribir_producto", "ep", op_escribir_producto, false },
+    { "escribir_ciudad",   "ec", op_escribir_ciudad,   false },
+    { "poner_prod",        "pp", op_poner_prod,        true },
+    { "modificar_prod",    "mp", op_modificar_prod,    true },
+    { "quitar_prod",       "qp", op_quitar_prod,       true },
+    { "consultar_prod",    "cp", op_consultar_prod,    false },
+    { "comerciar",         "co", op_comerciar,         true },
+    { "redistribuir",      "re", op_redistribuir,      true },
+    { "hacer_viaje",       "hv", op_hacer_viaje,       true },
+    { "//",                "//", op_comentario,        false },
+    { "guardar_estado",    "ge", op_guardar_estado,    false },
+    { "cargar_estado",     "ce", op_cargar_estado,     false }, // Anota la imagen.
+    { "consultar_cache",   "cc", op_consultar_cache,   false },
+    { "comerciar_lote",    "cl", op_comerciar_lote,    true },
+    { "simular_viajes",    "sv", op_simular_viajes,    false },
+    { "modificar_flota",   "mf", op_modificar_flota,   true },
+    { "escribir_flota",    "ef", op_escribir_flota,    false },
+    { "viajes_flota",      "vf", op_viajes_flota,      true },
+    { "excedentes_prod",   "xp", op_excedentes_prod,   false },
+    { "deficits_prod",     "dp", op_deficits_prod,     false },
+    { "totales_prod",      "tp", op_totales_prod,      false },
+    { "totales_afluente",  "ta", op_totales_afluente,  false },
+    { "distancia_rio",     "dr", op_distancia_rio,     false },
+    { "camino_rio",        "cr", op_camino_rio,        false },
+};
+static const int NUM_COMANDOS = sizeof(COMANDOS) / sizeof(COMANDOS[0]);
+
+/** @brief Código del comando que termina la simulación. */
+static const int FIN = -2;
+
+/** @brief Código con el que se anota la lectura inicial en el diario. */
+static const int LECTURA_INICIAL = Diario::MAX_CODIGO;
+
+// Antes de que la salida de un comando sea visible, su anotación debe estar
+// en disco. También se confirma antes de esperar más entrada, para que las
+// anotaciones no queden sin sincronizar mientras el programa está parado. Si
+// el diario no se puede escribir, se termina sin mostrar nada más: seguir
+// mostraría cambios que una recuperación no podría reproducir.
+static void confirmar_diario(void* diario) {
+    if (not ((Diario*)diario)->confirmar()) {
+        cerr << "error: no se puede escribir el diario" << endl;
+        _Exit(1);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Estado e;
+    Lector in;
+    Diario diario;
+    const char* fichero_diario = nullptr;
+    int num_hilos = 1;
+    int corte = Cuenca::CORTE_PARALELO;
+
+    // Con -i la salida de cada comando se vuelca en cuanto termina; si no,
+    // solo cuando se llena el búfer o al acabar. Con -d se anotan los comandos
+    // que modifican el estado en un diario. Con -t y -c se fijan los hilos y el
+    // tamaño mínimo de un subárbol para repartirlo. Si se da un fichero, el
+    // guion se lee de él en lugar del canal estándar de entrada.
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-i") == 0) {
+            salida.modo_interactivo(true);
+        } else if (strcmp(argv[i], "-d") == 0 and i + 1 < argc) {
+            fichero_diario = argv[++i];
+        } else if (strcmp(argv[i], "-t") == 0 and i + 1 < argc) {
+            num_hilos = max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "-c") == 0 and i + 1 < argc) {
+            corte = max(1, atoi(argv[++i]));
+        } else if (not in.abrir(argv[i])) {
+            cerr << "error: no se puede abrir " << argv[i] << endl;
+            return 1;
         }
-        
-        else if (op == "consultar_prod" or op == "cp") {
-            string id_ciudad;
-            int id_producto;
-            cin >> id_ciudad >> id_producto;
-            cout << '#' << op << ' ' << id_ciudad << ' ' << id_producto << endl;
-            c.consultar_prod_ciudad(id_ciudad, id_producto, cp);
+    }
+
+    Pool_hilos pool(num_hilos);
+    if (num_hilos > 1) e.c.usar_hilos(&pool, corte);
+
+    // Los nombres largos tienen código 2i y las abreviaturas 2i+1, así se
+    // sabe con qué nombre se ha escrito el comando sin guardar la palabra.
+    Tabla_comandos tabla;
+    for (int i = 0; i < NUM_COMANDOS; ++i) {
+        tabla.registrar(COMANDOS[i].nombre, 2*i);
+        if (strcmp(COMANDOS[i].abreviatura, COMANDOS[i].nombre) != 0) {
+            tabla.registrar(COMANDOS[i].abreviatura, 2*i + 1);
         }
-        
-        else if (op == "comerciar" or op == "co") {
-            string id_ciudad1, id_ciudad2;
-            cin >> id_ciudad1 >> id_ciudad2;
-            cout << '#' << op << ' ' << id_ciudad1 << ' ' << id_ciudad2 << endl;
-            c.comerciar(id_ciudad1, id_ciudad2, cp);
+    }
+    tabla.registrar("fin", FIN);
+
+    // Recuperación: se vuelven a aplicar los comandos del diario sin generar
+    // salida. Si había algo, el estado ya incluye la lectura inicial.
+    bool recuperado = false;
+    if (fichero_diario != nullptr) {
+        int num;
+        salida.silenciar(true);
+        bool ok = diario.abrir(fichero_diario, [&e](int codigo, const Token& t) {
+            if (codigo == IMAGEN_ESTADO) {
+                Lector_binario imagen(t.p, t.n);
+                e.c.cargar_estado(imagen, e.cp, e.b, e.f);
+                return;
+            }
+            Lector args(t.p, t.n);
+            if (codigo == LECTURA_INICIAL) {
+                e.c.lectura_inicial(e.cp, e.b, args);
+            } else if (codigo < NUM_COMANDOS) {
+                COMANDOS[codigo].atender(e, args, COMANDOS[codigo].nombre);
+            }
+        }, num);
+        salida.silenciar(false);
+        if (not ok) {
+            cerr << "error: no se puede abrir " << fichero_diario << endl;
+            return 1;
         }
-        
-        else if (op == "redistribuir" or op == "re") {
-            cout << '#' << op << endl;
-            c.redistribuir(cp);
+        recuperado = num > 0;
+        e.diario = &diario;
+        salida.antes_de_volcar(confirmar_diario, &diario);
+        in.antes_de_esperar(confirmar_diario, &diario);
+    }
+
+    // Solo se marca la entrada cuando hay diario: mientras hay marca, el
+    // lector conserva en el búfer todo el texto del comando. Hasta que el
+    // comando está anotado se retiene su salida, para que no se vea nada de
+    // un cambio que aún no está en el diario.
+    if (not recuperado) {
+        if (fichero_diario != nullptr) {
+            in.marcar();
+            salida.retener(true);
         }
-        
-        else if (op == "hacer_viaje" or op == "hv") {
-            cout << '#' << op << endl;
-            c.hacer_viaje(b,cp);
+        e.c.lectura_inicial(e.cp, e.b, in);
+        if (fichero_diario != nullptr) {
+            diario.anotar(LECTURA_INICIAL, in.desde_marca());
+            salida.retener(false);
         }
-
-        else if (op == "//") {
-            string comentario;
-            getline(cin, comentario);
+    }
+    
+   // COMANDOS
+   
+    Token op;
+    while (in.leer_token(op)) {
+        int codigo = tabla.buscar(op);
+        if (codigo == FIN) break;
+        if (codigo >= 0) {
+            const Comando& com = COMANDOS[codigo / 2];
+            bool anotar = fichero_diario != nullptr and com.modifica;
+            if (anotar) {
+                in.marcar();
+                salida.retener(true);
+            }
+            com.atender(e, in, codigo % 2 == 0 ? com.nombre : com.abreviatura);
+            if (anotar) {
+                diario.anotar(codigo / 2, in.desde_marca());
+                salida.retener(false);
+            }
+            salida.volcar_interactivo();
         }
     }
+    salida.volcar();
+    confirmar_diario(&diario);
+    salida.antes_de_volcar(nullptr, nullptr);
 }
\ No newline at end of file
@@ -0,0 +1,217 @@
+/** @file prueba_arboles.cc
+    @brief Prueba de BinTree y ArenaBinTree.
+
+    El programa no usa directamente ninguna de las dos plantillas, así que
+    esta prueba es lo que las compila: construye árboles aleatorios de varias
+    formas y comprueba los recorridos con iteradores, los movimientos, los
+    formatos de entrada y salida (incluido BINARYFORMAT) y que un
+    ArenaBinTree construido igual que un BinTree tiene la misma forma y los
+    mismos valores. Escribe los fallos y termina con estado 1 si hay alguno.
+*/
+
+#include "BinTree.hh"
+#include "ArenaBinTree.hh"
+
+#ifndef NO_DIAGRAM
+#include <iostream>
+#include <sstream>
+#include <random>
+#include <climits>
+#include <vector>
+#endif
+
+using namespace std;
+
+typedef BinTree<string> Arbol;
+typedef ArenaBinTree<string> Arbol_arena;
+
+static mt19937 azar(7);
+static int fallos = 0;
+
+// Pre: cierto.
+// Post: Si no se cumple la condición, se ha escrito el fallo y se ha contado.
+
+static void comprobar(bool condicion, const string& que) {
+    if (not condicion) {
+        cout << "fallo: " << que << endl;
+        ++fallos;
+    }
+}
+
+// Pre: n >= 0.
+// Post: Devuelve el tamaño del hijo izquierdo de un árbol de n nodos con la
+// forma indicada: 0 aleatoria, 1 y 2 cadenas hacia un lado, 3 zigzag.
+
+static int tam_izquierdo(int n, int forma) {
+    if (forma == 0) return azar() % n;
+    if (forma == 1) return n - 1;
+    if (forma == 2) return 0;
+    return azar() % 2 ? 0 : n - 1;
+}
+
+// Pre: n >= 0.
+// Post: a y b son el mismo árbol de n nodos, uno de cada clase. Los subárboles
+// de a se construyen a veces dentro de una región propia.
+
+static void construir(int n, int forma, Arbol& a, Arbol_arena& b, int& id) {
+    if (n == 0) {
+        a = Arbol();
+        b = Arbol_arena();
+        return;
+    }
+    int l = tam_izquierdo(n, forma);
+    Arbol ai, ad;
+    Arbol_arena bi, bd;
+    if (azar() % 7 == 0) {
+        Arbol_arena::Region r;
+        construir(l, forma, ai, bi, id);
+        construir(n - 1 - l, forma, ad, bd, id);
+    } else {
+        construir(l, forma, ai, bi, id);
+        construir(n - 1 - l, forma, ad, bd, id);
+    }
+    // Valores largos, para que no quepan en el string sin memoria dinámica.
+    string v = "nodo_con_un_nombre_largo_" + to_string(id++);
+    b = Arbol_arena(v, bi, bd);
+    if (azar() % 2) a = Arbol(move(v), move(ai), move(ad));
+    else a = Arbol(v, ai, ad);
+}
+
+// Pre: cierto.
+// Post: Devuelve cierto si a y b tienen la misma forma y los mismos valores.
+
+static bool iguales(const Arbol& a, const Arbol_arena& b) {
+    if (a.empty() or b.empty()) return a.empty() == b.empty();
+    return a.value() == b.value() and iguales(a.left(), b.left()) and iguales(a.right(), b.right());
+}
+
+// Pre: cierto.
+// Post: Se han añadido a v los valores de a en preorden, inorden o postorden.
+
+static void preorden(const Arbol& a, vector<string>& v) {
+    if (a.empty()) return;
+    v.push_back(a.value());
+    preorden(a.left(), v);
+    preorden(a.right(), v);
+}
+
+static void inorden(const Arbol& a, vector<string>& v) {
+    if (a.empty()) return;
+    inorden(a.left(), v);
+    v.push_back(a.value());
+    inorden(a.right(), v);
+}
+
+static void postorden(const Arbol& a, vector<string>& v) {
+    if (a.empty()) return;
+    postorden(a.left(), v);
+    postorden(a.right(), v);
+    v.push_back(a.value());
+}
+
+// Pre: cierto.
+// Post: Devuelve a escrito con el formato indicado.
+
+template <typename T>
+static string escribir(BinTree<T> a, int formato) {
+    ostringstream out;
+    a.setOutputFormat(formato);
+    out << a;
+    return out.str();
+}
+
+// Pre: texto contiene un árbol escrito con el formato indicado.
+// Post: Devuelve el árbol leído; leido_todo indica si se ha consumido todo el texto.
+
+template <typename T>
+static BinTree<T> leer(const string& texto, int formato, bool& leido_todo) {
+    BinTree<T> a;
+    a.setInputFormat(formato);
+    istringstream in(texto);
+    in >> a;
+    leido_todo = in.peek() == EOF;
+    return a;
+}
+
+// Pre: cierto.
+// Post: Se ha comprobado que a vuelve igual de BINARYFORMAT y, si texto, que
+// cada formato de texto da lo mismo antes y después de pasar por binario.
+
+template <typename T>
+static void comprobar_formatos(const BinTree<T>& a, bool texto) {
+    const int BINARIO = BinTree<T>::BINARYFORMAT;
+    bool leido_todo;
+    string bin = escribir(a, BINARIO);
+    BinTree<T> b = leer<T>(bin, BINARIO, leido_todo);
+    comprobar(leido_todo and escribir(b, BINARIO) == bin, "ida y vuelta en binario");
+    for (int f = 1; texto and f < BINARIO; ++f) {
+        string txt = escribir(a, f);
+        comprobar(escribir(b, f) == txt, "formato " + to_string(f) + " tras binario");
+        BinTree<T> c = leer<T>(txt, f, leido_todo);
+        comprobar(escribir(leer<T>(escribir(c, BINARIO), BINARIO, leido_todo), f) == txt,
+                  "formato " + to_string(f) + " a binario y vuelta");
+    }
+}
+
+// Pre: n >= 0.
+// Post: Devuelve un árbol de enteros de n nodos con valores en los extremos del tipo.
+
+static BinTree<int> arbol_enteros(int n, int forma) {
+    if (n == 0) return BinTree<int>();
+    int l = tam_izquierdo(n, forma);
+    BinTree<int> i = arbol_enteros(l, forma);
+    BinTree<int> d = arbol_enteros(n - 1 - l, forma);
+    int k = azar() % 4;
+    return BinTree<int>(k == 0 ? INT_MIN : k == 1 ? INT_MAX : int(azar()), i, d);
+}
+
+int main() {
+    for (int it = 0; it < 200; ++it) {
+        int n = azar() % (it < 150 ? 100 : 2000);
+        int forma = it % 4;
+        int id = 0;
+        Arbol a;
+        Arbol_arena b;
+        if (it % 2) {
+            Arbol_arena::Region r;
+            construir(n, forma, a, b, id);
+        } else {
+            construir(n, forma, a, b, id);
+        }
+        comprobar(iguales(a, b), "ArenaBinTree distinto de BinTree");
+
+        // Los recorridos con iteradores dan lo mismo que los recursivos.
+        vector<string> pre, in, post, it_pre, it_in, it_post;
+        preorden(a, pre);
+        inorden(a, in);
+        postorden(a, post);
+        for (const string& s : a.preorder()) it_pre.push_back(s);
+        for (auto i = a.inorder().begin(); i != a.inorder().end(); i++) it_in.push_back(*i);
+        for (const string& s : a.postorder()) it_post.push_back(s);
+        comprobar(pre == it_pre and in == it_in and post == it_post, "recorridos con iteradores");
+
+        // Un movimiento deja el origen vacío y no toca los nodos.
+        Arbol c = move(a);
+        Arbol_arena d = move(b);
+        comprobar(a.empty() and b.empty() and iguales(c, d), "movimientos");
+
+        comprobar_formatos(c, it < 100);
+        comprobar_formatos(arbol_enteros(azar() % 100, forma), true);
+    }
+
+    // Valor construido en su sitio y varios árboles seguidos en un canal.
+    Arbol e(BINTREEEMPLACE, Arbol(), Arbol(), 3, 'x');
+    comprobar(e.value() == "xxx", "construccion en su sitio");
+    BinTree<int> x(1, BinTree<int>(2), BinTree<int>()), vacio;
+    string dos = escribir(x, BinTree<int>::BINARYFORMAT) + escribir(vacio, BinTree<int>::BINARYFORMAT);
+    istringstream canal(dos);
+    BinTree<int> p, q;
+    p.setInputFormat(BinTree<int>::BINARYFORMAT);
+    q.setInputFormat(BinTree<int>::BINARYFORMAT);
+    canal >> p >> q;
+    comprobar(p.value() == 1 and p.left().value() == 2 and p.right().empty() and q.empty(),
+              "varios arboles en un canal");
+
+    if (fallos > 0) return 1;
+    cout << "ok" << endl;
+}